@@ -0,0 +1,392 @@
+/*
+  ==============================================================================
+
+    Parameters.cpp
+    Created: 16 Oct 2026 5:02:19pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "Parameters.h"
+
+namespace Parameters {
+
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout(){
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+    
+    auto inputdB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(inputID, 1), "Input", juce::NormalisableRange<float>(-10.0f, 10.0f), 0.0f);
+    
+    const juce::StringArray choices {"4:1", "8:1", "12:1", "20:1"};
+    auto ratio = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ratioID, 1), "Ratio", choices, 0);
+    
+    auto thresholddB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(thresholdID, 1), "Threshold", juce::NormalisableRange<float>(-60.0f, 10.0f), 0.0f);
+    
+    // attack in MICROSECONDS
+    auto attackTime = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(attackID, 1), "Attack", juce::NormalisableRange<float>(20.0f, 800.0f, 0.5f), 400.0f);
+    
+    // release in MS
+    auto releaseTime = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(releaseID, 1), "Release", juce::NormalisableRange<float>(50.0f, 1100.0f, 0.5f), 250.0f);
+    
+    auto bypass = std::make_unique<juce::AudioParameterBool>(juce::ParameterID(bypassID, 1), "Bypass", false);
+    
+    auto outputdB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(outputID, 1), "Output", juce::NormalisableRange<float>(-10.0f, 10.0f), 0.0f);
+    
+    // gain computer, Fast trades < 0.0001 dB of accuracy for a much cheaper VCA
+    const juce::StringArray engines {"Exact", "Fast"};
+    auto engine = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(engineID, 1), "Engine", engines, 0);
+    
+    // how often the gain computer runs, the gain is interpolated in between
+    const juce::StringArray gainRates {"Full", "1/4", "1/8", "1/16"};
+    auto gainRate = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(gainRateID, 1), "Gain Rate", gainRates, 0);
+    
+    // one detector per channel, or one shared by all of them
+    const juce::StringArray links {"Off", "Max", "Mean"};
+    auto link = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(linkID, 1), "Link", links, 0);
+    
+    // lookahead in MS, delays the audio and reports it as latency
+    auto lookaheadTime = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(lookaheadID, 1), "Lookahead", juce::NormalisableRange<float>(0.0f, static_cast<float>(Compressor<float>::maxLookaheadMs), 0.01f), 0.0f);
+    
+    // oversampling of the compressor stage, the choice index is the log2 of the factor
+    const juce::StringArray factors {"Off", "2x", "4x", "8x"};
+    auto oversampling = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(oversamplingID, 1), "Oversampling", factors, 0);
+    
+    const juce::StringArray filters {"IIR", "Linear Phase"};
+    auto oversamplingFilter = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(oversamplingFilterID, 1), "Oversampling Filter", filters, 0);
+    
+    // detector key, the sidechain bus instead of the input, optionally high-passed
+    auto sidechain = std::make_unique<juce::AudioParameterBool>(juce::ParameterID(sidechainID, 1), "External Key", false);
+    
+    auto keyFilter = std::make_unique<juce::AudioParameterBool>(juce::ParameterID(keyFilterID, 1), "Key Filter", false);
+    
+    // key filter cutoff in HZ
+    auto keyFrequency = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(keyFrequencyID, 1), "Key Frequency", juce::NormalisableRange<float>(20.0f, 2000.0f, 1.0f, 0.3f), 100.0f);
+    
+    // what the ballistics follow
+    const juce::StringArray detectors {"Peak", "RMS"};
+    auto detector = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(detectorID, 1), "Detector", detectors, 0);
+    
+    // RMS window in MS
+    auto rmsWindowTime = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(rmsWindowID, 1), "RMS Window", juce::NormalisableRange<float>(1.0f, static_cast<float>(Compressor<float>::maxRmsWindowMs), 0.1f, 0.5f), 10.0f);
+    
+    // knee width in DB, 0 is a hard knee
+    auto kneedB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(kneeID, 1), "Knee", juce::NormalisableRange<float>(0.0f, 24.0f, 0.1f), 0.0f);
+    
+    // steps down to cheaper processing while the blocks take longer than the
+    // budget, a percentage of their duration
+    auto adaptiveQuality = std::make_unique<juce::AudioParameterBool>(juce::ParameterID(adaptiveQualityID, 1), "Adaptive Quality", false);
+    
+    auto cpuBudget = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(cpuBudgetID, 1), "CPU Budget", juce::NormalisableRange<float>(10.0f, 100.0f, 1.0f), 70.0f);
+    
+    // the level adaptive quality is at, set by the processor only. Hosts show
+    // meter parameters as read-only.
+    const juce::StringArray qualityLevels {"Full", "Fast Gain", "Control Rate", "No Oversampling"};
+    auto qualityLevel = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(qualityLevelID, 1), "Quality Level", qualityLevels, 0,
+                                                                     juce::AudioParameterChoiceAttributes().withAutomatable(false)
+                                                                                                           .withCategory(juce::AudioProcessorParameter::otherMeter));
+    
+    params.push_back(std::move(inputdB));
+    params.push_back(std::move(ratio));
+    params.push_back(std::move(thresholddB));
+    params.push_back(std::move(attackTime));
+    params.push_back(std::move(releaseTime));
+    params.push_back(std::move(bypass));
+    params.push_back(std::move(outputdB));
+    params.push_back(std::move(engine));
+    params.push_back(std::move(gainRate));
+    params.push_back(std::move(link));
+    params.push_back(std::move(lookaheadTime));
+    params.push_back(std::move(oversampling));
+    params.push_back(std::move(oversamplingFilter));
+    params.push_back(std::move(sidechain));
+    params.push_back(std::move(keyFilter));
+    params.push_back(std::move(keyFrequency));
+    params.push_back(std::move(detector));
+    params.push_back(std::move(rmsWindowTime));
+    params.push_back(std::move(kneedB));
+    params.push_back(std::move(adaptiveQuality));
+    params.push_back(std::move(cpuBudget));
+    params.push_back(std::move(qualityLevel));
+
+    return { params.begin(), params.end() };
+}
+
+//==============================================================================
+/** Reads every field of the snapshot through valueOf (parameter ID -> plain value) */
+template <typename ValueOf>
+static Snapshot makeSnapshot(ValueOf&& valueOf){
+    Snapshot snapshot;
+    
+    snapshot.inputdB     = valueOf(inputID);
+    snapshot.outputdB    = valueOf(outputID);
+    snapshot.thresholddB = valueOf(thresholdID);
+    snapshot.attackTime  = valueOf(attackID);
+    snapshot.releaseTime = valueOf(releaseID);
+    snapshot.ratio       = getRatioFromChoice(static_cast<int>(valueOf(ratioID)));
+    snapshot.engine      = static_cast<int>(valueOf(engineID));
+    snapshot.gainRateInterval = getGainRateIntervalFromChoice(static_cast<int>(valueOf(gainRateID)));
+    snapshot.link        = static_cast<int>(valueOf(linkID));
+    snapshot.lookaheadTime = valueOf(lookaheadID);
+    snapshot.oversamplingFactorLog2 = static_cast<int>(valueOf(oversamplingID));
+    snapshot.oversamplingFilter     = static_cast<int>(valueOf(oversamplingFilterID));
+    snapshot.bypassed    = valueOf(bypassID) >= 0.5f;
+    snapshot.useSidechain = valueOf(sidechainID) >= 0.5f;
+    snapshot.keyFilter    = valueOf(keyFilterID) >= 0.5f;
+    snapshot.keyFrequency = valueOf(keyFrequencyID);
+    snapshot.detector     = static_cast<int>(valueOf(detectorID));
+    snapshot.rmsWindowTime = valueOf(rmsWindowID);
+    snapshot.kneedB       = valueOf(kneeID);
+    snapshot.adaptiveQuality = valueOf(adaptiveQualityID) >= 0.5f;
+    snapshot.cpuBudget       = valueOf(cpuBudgetID) * 0.01f;
+    
+    // Adaptive quality may drop the oversampling, the latency shouldn't follow
+    snapshot.latencyFactorLog2 = snapshot.adaptiveQuality ? snapshot.oversamplingFactorLog2 : 0;
+    
+    return snapshot;
+}
+
+Snapshot readSnapshot(const juce::AudioProcessorValueTreeState& treeState){
+    return makeSnapshot([&](const char* parameterId){
+        return treeState.getRawParameterValue(parameterId)->load();
+    });
+}
+
+Snapshot readSnapshot(const juce::AudioProcessorValueTreeState& treeState, const Values& values){
+    return makeSnapshot([&](const char* parameterId){
+        const auto index = static_cast<size_t>(treeState.getParameter(parameterId)->getParameterIndex());
+        jassert (index < values.size());
+        return values[index];
+    });
+}
+
+template <typename SampleType>
+void applySnapshot(ChannelStrip<SampleType>& channelStrip, const Snapshot& snapshot,
+                   const Snapshot& previous, bool force,
+                   const typename Compressor<SampleType>::Coefficients* coefficients){
+    auto& compressor = channelStrip.getCompressor();
+    
+    if (force || snapshot.inputdB != previous.inputdB)
+        channelStrip.setInputGainDecibels(snapshot.inputdB);
+    
+    if (force || snapshot.outputdB != previous.outputdB)
+        channelStrip.setOutputGainDecibels(snapshot.outputdB);
+    
+    if (force || snapshot.thresholddB != previous.thresholddB)
+        compressor.setThreshold(snapshot.thresholddB);
+    
+    if (force || snapshot.attackTime != previous.attackTime)
+        compressor.setAttack(snapshot.attackTime);
+    
+    if (force || snapshot.releaseTime != previous.releaseTime)
+        compressor.setRelease(snapshot.releaseTime);
+    
+    if (force || snapshot.ratio != previous.ratio)
+        compressor.setRatio(snapshot.ratio);
+    
+    if (force || snapshot.engine != previous.engine)
+        compressor.setGainEngine(snapshot.engine == EngineChoice::Fast ? GainEngine::fastApproximation
+                                                                       : GainEngine::exact);
+    
+    if (force || snapshot.gainRateInterval != previous.gainRateInterval)
+        compressor.setControlRateInterval(snapshot.gainRateInterval);
+    
+    if (force || snapshot.link != previous.link)
+        compressor.setDetectorLink(getDetectorLinkFromChoice(snapshot.link));
+    
+    if (force || snapshot.lookaheadTime != previous.lookaheadTime)
+        channelStrip.setLookahead(snapshot.lookaheadTime);
+    
+    if (force || snapshot.latencyFactorLog2 != previous.latencyFactorLog2)
+        channelStrip.setLatencyFactor(snapshot.latencyFactorLog2);
+    
+    if (force || snapshot.oversamplingFactorLog2 != previous.oversamplingFactorLog2
+              || snapshot.oversamplingFilter != previous.oversamplingFilter)
+        channelStrip.setOversampling(snapshot.oversamplingFactorLog2,
+                                     snapshot.oversamplingFilter == OversamplingFilterChoice::LinearPhaseFIR);
+    
+    if (force || snapshot.bypassed != previous.bypassed)
+        channelStrip.setBypassed(snapshot.bypassed);
+    
+    if (force || snapshot.keyFilter != previous.keyFilter || snapshot.keyFrequency != previous.keyFrequency)
+        compressor.setDetectorHighPass(snapshot.keyFilter ? snapshot.keyFrequency : 0.0f);
+    
+    if (force || snapshot.detector != previous.detector)
+        compressor.setDetectorMode(snapshot.detector == DetectorChoice::RMS ? DetectorMode::rms : DetectorMode::peak);
+    
+    if (force || snapshot.rmsWindowTime != previous.rmsWindowTime)
+        compressor.setRmsWindow(snapshot.rmsWindowTime);
+    
+    if (force || snapshot.kneedB != previous.kneedB)
+        compressor.setKneeWidth(snapshot.kneedB);
+    
+    // After the oversampling, which moves the compressor to its new rate
+    if (coefficients != nullptr)
+        compressor.setCoefficients(*coefficients);
+}
+
+template <typename SampleType>
+typename Compressor<SampleType>::Coefficients makeCoefficients(const Snapshot& snapshot, double sampleRate){
+    // Unprepared, only its setters and update() run
+    Compressor<SampleType> compressor;
+    
+    compressor.setThreshold(snapshot.thresholddB);
+    compressor.setRatio(static_cast<SampleType>(snapshot.ratio));
+    compressor.setKneeWidth(snapshot.kneedB);
+    compressor.setAttack(snapshot.attackTime);
+    compressor.setRelease(snapshot.releaseTime);
+    compressor.setDetectorHighPass(snapshot.keyFilter ? snapshot.keyFrequency : 0.0f);
+    compressor.setSampleRate(sampleRate * (1 << snapshot.oversamplingFactorLog2));
+    
+    return compressor.getCoefficients();
+}
+
+Snapshot withQualityLevel(const Snapshot& snapshot, AdaptiveQuality::Level level){
+    auto result = snapshot;
+    
+    if (level >= AdaptiveQuality::fastGain)
+        result.engine = EngineChoice::Fast;
+    
+    if (level >= AdaptiveQuality::controlRate)
+        result.gainRateInterval = juce::jmax(result.gainRateInterval, getGainRateIntervalFromChoice(GainRateChoice::Eighth));
+    
+    if (level >= AdaptiveQuality::noOversampling)
+        result.oversamplingFactorLog2 = 0;
+    
+    return result;
+}
+
+juce::uint32 getUsefulQualityLevels(const Snapshot& snapshot){
+    auto levels = 1u << AdaptiveQuality::full;
+    
+    if (snapshot.engine != EngineChoice::Fast)
+        levels |= 1u << AdaptiveQuality::fastGain;
+    
+    if (snapshot.gainRateInterval < getGainRateIntervalFromChoice(GainRateChoice::Eighth))
+        levels |= 1u << AdaptiveQuality::controlRate;
+    
+    if (snapshot.oversamplingFactorLog2 > 0)
+        levels |= 1u << AdaptiveQuality::noOversampling;
+    
+    return levels;
+}
+
+//==============================================================================
+Values getDefaultValues(const juce::AudioProcessorValueTreeState& treeState){
+    Values values;
+    
+    for (auto* parameter : treeState.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            values.push_back(ranged->convertFrom0to1(ranged->getDefaultValue()));
+    
+    return values;
+}
+
+Values getValues(const juce::AudioProcessorValueTreeState& treeState){
+    Values values;
+    
+    for (auto* parameter : treeState.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            values.push_back(ranged->convertFrom0to1(ranged->getValue()));
+    
+    return values;
+}
+
+void setValues(juce::AudioProcessorValueTreeState& treeState, const Values& values){
+    const auto& parameters = treeState.processor.getParameters();
+    jassert (values.size() == static_cast<size_t>(parameters.size()));
+    
+    // Read-only parameters, like the quality level, are only set by the processor
+    for (int i = 0; i < parameters.size() && i < static_cast<int>(values.size()); ++i)
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[i]); ranged != nullptr && ranged->isAutomatable())
+            ranged->setValueNotifyingHost(ranged->convertTo0to1(values[static_cast<size_t>(i)]));
+}
+
+void writeValues(const juce::AudioProcessorValueTreeState& treeState, const Values& values, juce::OutputStream& stream){
+    const auto& parameters = treeState.processor.getParameters();
+    jassert (values.size() == static_cast<size_t>(parameters.size()));
+    
+    stream.writeCompressedInt(parameters.size());
+    
+    for (int i = 0; i < parameters.size(); ++i)
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[i]);
+        stream.writeString(ranged != nullptr ? ranged->getParameterID() : juce::String());
+        stream.writeFloat(values[static_cast<size_t>(i)]);
+    }
+}
+
+bool readValues(const juce::AudioProcessorValueTreeState& treeState, juce::InputStream& stream, Values& values){
+    values = getDefaultValues(treeState);
+    
+    const auto numValues = stream.readCompressedInt();
+    
+    if (numValues < 0)
+        return false;
+    
+    for (int i = 0; i < numValues; ++i)
+    {
+        if (stream.isExhausted())
+            return false;
+        
+        const auto parameterId = stream.readString();
+        const auto value = stream.readFloat();
+        
+        if (auto* parameter = treeState.getParameter(parameterId))
+        {
+            const auto& range = parameter->getNormalisableRange();
+            values[static_cast<size_t>(parameter->getParameterIndex())] = range.snapToLegalValue(value);
+        }
+    }
+    
+    return true;
+}
+
+//==============================================================================
+int getRatioFromChoice(int choice){
+    switch (choice) {
+        case RatioChoice::Four:
+            return 4;
+        case RatioChoice::Eight:
+            return 8;
+        case RatioChoice::Twelve:
+            return 12;
+        case RatioChoice::Twenty:
+            return 20;
+    }
+    
+    return 4;
+}
+
+int getGainRateIntervalFromChoice(int choice){
+    switch (choice) {
+        case GainRateChoice::Full:
+            return 1;
+        case GainRateChoice::Quarter:
+            return 4;
+        case GainRateChoice::Eighth:
+            return 8;
+        case GainRateChoice::Sixteenth:
+            return 16;
+    }
+    
+    return 1;
+}
+
+DetectorLink getDetectorLinkFromChoice(int choice){
+    switch (choice) {
+        case LinkChoice::LinkedMaximum:
+            return DetectorLink::maximum;
+        case LinkChoice::LinkedMean:
+            return DetectorLink::mean;
+    }
+    
+    return DetectorLink::independent;
+}
+
+//==============================================================================
+template void applySnapshot<float>  (ChannelStrip<float>&,  const Snapshot&, const Snapshot&, bool, const Compressor<float>::Coefficients*);
+template void applySnapshot<double> (ChannelStrip<double>&, const Snapshot&, const Snapshot&, bool, const Compressor<double>::Coefficients*);
+template Compressor<float>::Coefficients  makeCoefficients<float>  (const Snapshot&, double);
+template Compressor<double>::Coefficients makeCoefficients<double> (const Snapshot&, double);
+
+} // namespace Parameters
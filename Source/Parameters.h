@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    Parameters.h
+    Created: 16 Oct 2026 5:02:19pm
+    Author:  Chris
+ 
+    The parameter layout and the mapping from parameter values to the DSP,
+    shared by the plugin and the headless tools so they always agree on
+    ranges, defaults and choices.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Processing/ChannelStrip.h"
+#include "Processing/AdaptiveQuality.h"
+
+enum RatioChoice { Four, Eight, Twelve, Twenty };
+enum EngineChoice { Exact, Fast };
+enum GainRateChoice { Full, Quarter, Eighth, Sixteenth };
+enum LinkChoice { Independent, LinkedMaximum, LinkedMean };
+enum OversamplingFilterChoice { PolyphaseIIR, LinearPhaseFIR };
+enum DetectorChoice { Peak, RMS };
+
+namespace Parameters {
+
+//==============================================================================
+inline constexpr auto inputID     = "INPUT";
+inline constexpr auto ratioID     = "RATIO";
+inline constexpr auto thresholdID = "THRESHOLD";
+inline constexpr auto attackID    = "ATTACK";
+inline constexpr auto releaseID   = "RELEASE";
+inline constexpr auto outputID    = "OUTPUT";
+inline constexpr auto bypassID    = "BYPASS";
+inline constexpr auto engineID    = "ENGINE";
+inline constexpr auto gainRateID  = "GAIN_RATE";
+inline constexpr auto linkID      = "LINK";
+inline constexpr auto lookaheadID = "LOOKAHEAD";
+inline constexpr auto oversamplingID       = "OVERSAMPLING";
+inline constexpr auto oversamplingFilterID = "OVERSAMPLING_FILTER";
+inline constexpr auto sidechainID    = "SIDECHAIN";
+inline constexpr auto keyFilterID    = "KEY_FILTER";
+inline constexpr auto keyFrequencyID = "KEY_FREQUENCY";
+inline constexpr auto detectorID  = "DETECTOR";
+inline constexpr auto rmsWindowID = "RMS_WINDOW";
+inline constexpr auto kneeID      = "KNEE";
+inline constexpr auto adaptiveQualityID = "ADAPTIVE_QUALITY";
+inline constexpr auto cpuBudgetID       = "CPU_BUDGET";
+inline constexpr auto qualityLevelID    = "QUALITY_LEVEL";
+
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+//==============================================================================
+/** The parameter values used by the DSP, in the units the DSP expects */
+struct Snapshot {
+    float inputdB = 0.0f, outputdB = 0.0f;
+    float thresholddB = 0.0f, attackTime = 400.0f, releaseTime = 250.0f;
+    int ratio = 4;
+    int engine = EngineChoice::Exact;
+    int gainRateInterval = 1;
+    int link = LinkChoice::Independent;
+    float lookaheadTime = 0.0f;
+    int oversamplingFactorLog2 = 0;
+    int oversamplingFilter = OversamplingFilterChoice::PolyphaseIIR;
+    int latencyFactorLog2 = 0;       // see ChannelStrip::setLatencyFactor()
+    bool bypassed = false;
+    bool useSidechain = false;    // read by the processor, the strip only sees the key
+    bool keyFilter = false;
+    float keyFrequency = 100.0f;
+    int detector = DetectorChoice::Peak;
+    float rmsWindowTime = 10.0f, kneedB = 0.0f;
+    bool adaptiveQuality = false;    // read by the processor, like useSidechain
+    float cpuBudget = 0.7f;          // a fraction of the block duration
+};
+
+/** Reads every parameter from the tree state's atomic values. Safe to call
+    from the audio thread. */
+Snapshot readSnapshot (const juce::AudioProcessorValueTreeState& treeState);
+
+/** The plain value of every parameter, in the order of the layout */
+using Values = std::vector<float>;
+
+/** Reads the snapshot from values instead of the tree state's atomics */
+Snapshot readSnapshot (const juce::AudioProcessorValueTreeState& treeState, const Values& values);
+
+/** Forwards the fields of snapshot that differ from previous (or all of them
+    when force is true) to the channel strip. When coefficients is given, it
+    must come from makeCoefficients (snapshot, ...) at the strip's base rate:
+    the compressor takes it as is instead of recomputing its coefficients. */
+template <typename SampleType>
+void applySnapshot (ChannelStrip<SampleType>& channelStrip, const Snapshot& snapshot,
+                    const Snapshot& previous, bool force,
+                    const typename Compressor<SampleType>::Coefficients* coefficients = nullptr);
+
+/** The compressor coefficients of snapshot for a strip running at
+    sampleRate, at the oversampled rate the snapshot selects */
+template <typename SampleType>
+typename Compressor<SampleType>::Coefficients makeCoefficients (const Snapshot& snapshot, double sampleRate);
+
+/** snapshot, with what level gives up taken away from it. The latency
+    factor is kept, so the latency doesn't change with the level. */
+Snapshot withQualityLevel (const Snapshot& snapshot, AdaptiveQuality::Level level);
+
+/** The levels that give up anything snapshot doesn't already, for
+    AdaptiveQuality::setUsefulLevels() */
+juce::uint32 getUsefulQualityLevels (const Snapshot& snapshot);
+
+//==============================================================================
+Values getDefaultValues (const juce::AudioProcessorValueTreeState& treeState);
+
+Values getValues (const juce::AudioProcessorValueTreeState& treeState);
+
+/** Sets every parameter but the read-only ones to values, notifying the
+    host. Message thread only. */
+void setValues (juce::AudioProcessorValueTreeState& treeState, const Values& values);
+
+/** Writes values as the number of parameters, then an ID and a plain value
+    per parameter. The IDs keep old blocks readable when parameters are
+    added, removed or reordered. */
+void writeValues (const juce::AudioProcessorValueTreeState& treeState, const Values& values, juce::OutputStream& stream);
+
+/** Reads a block from writeValues(). Unknown IDs are skipped, parameters
+    missing from the block get their default, values are clamped to the
+    current ranges. Returns false if the block is truncated. */
+bool readValues (const juce::AudioProcessorValueTreeState& treeState, juce::InputStream& stream, Values& values);
+
+int getRatioFromChoice (int choice);
+int getGainRateIntervalFromChoice (int choice);
+DetectorLink getDetectorLinkFromChoice (int choice);
+
+} // namespace Parameters
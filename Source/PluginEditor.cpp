@@ -13,13 +13,73 @@
 CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
-    // Make sure that before the constructor has finished, you've set the
-    // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    addAndMakeVisible (transferCurve);
+    addAndMakeVisible (meter);
+    
+    addSlider (inputSlider,     labels[0], audioProcessor.paramInput);
+    addSlider (thresholdSlider, labels[1], audioProcessor.paramThreshold);
+    addSlider (kneeSlider,      labels[2], audioProcessor.paramKnee);
+    addSlider (attackSlider,    labels[3], audioProcessor.paramAttack);
+    addSlider (releaseSlider,   labels[4], audioProcessor.paramRelease);
+    addSlider (outputSlider,    labels[5], audioProcessor.paramOutput);
+    addSlider (lookaheadSlider, labels[6], audioProcessor.paramLookahead);
+    addSlider (keyFrequencySlider, labels[7], audioProcessor.paramKeyFrequency);
+    addSlider (rmsWindowSlider,    labels[8], audioProcessor.paramRmsWindow);
+    addSlider (cpuBudgetSlider,    labels[9], audioProcessor.paramCpuBudget);
+    
+    addComboBox (ratioBox,              labels[10], audioProcessor.paramRatio);
+    addComboBox (detectorBox,           labels[11], audioProcessor.paramDetector);
+    addComboBox (engineBox,             labels[12], audioProcessor.paramEngine);
+    addComboBox (gainRateBox,           labels[13], audioProcessor.paramGainRate);
+    addComboBox (linkBox,               labels[14], audioProcessor.paramLink);
+    addComboBox (oversamplingBox,       labels[15], audioProcessor.paramOversampling);
+    addComboBox (oversamplingFilterBox, labels[16], audioProcessor.paramOversamplingFilter);
+    
+    addButton (bypassButton,    audioProcessor.paramBypass);
+    addButton (sidechainButton, audioProcessor.paramSidechain);
+    addButton (keyFilterButton, audioProcessor.paramKeyFilter);
+    addButton (adaptiveButton,  audioProcessor.paramAdaptiveQuality);
+    
+    // Selecting moves the parameters, so the attachments follow by themselves
+    presetBox.onChange = [this]
+    {
+        if (presetBox.getSelectedItemIndex() >= 0)
+            audioProcessor.setCurrentProgram (presetBox.getSelectedItemIndex());
+    };
+    storeButton.onClick = [this] { audioProcessor.storePreset (presetBox.getSelectedItemIndex()); };
+    addAndMakeVisible (presetBox);
+    addAndMakeVisible (storeButton);
+    updatePresetBox();
+    
+   #if JUCE_MODULE_AVAILABLE_juce_opengl
+    addAndMakeVisible (openGLButton);
+    openGLButton.onClick = [this]
+    {
+        if (openGLButton.getToggleState())
+            openGLContext.attachTo (*this);
+        else
+            openGLContext.detach();
+    };
+   #endif
+    
+    updateCurve();
+    
+    // Whatever queued up while the editor was closed is stale
+    MeterFrame staleFrames;
+    audioProcessor.getMeterQueue().popAll (staleFrames);
+    lastFrameTime = juce::Time::getMillisecondCounterHiRes();
+    startTimerHz (maxFrameRate);
+    
+    setSize (840, 420);
 }
 
 CompressorAudioProcessorEditor::~CompressorAudioProcessorEditor()
 {
+    stopTimer();
+    
+   #if JUCE_MODULE_AVAILABLE_juce_opengl
+    openGLContext.detach();
+   #endif
 }
 
 //==============================================================================
@@ -27,14 +87,136 @@ void CompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void CompressorAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto area = getLocalBounds().reduced (10);
+    
+    auto display = area.removeFromTop (220);
+    meter.setBounds (display.removeFromRight (110));
+    display.removeFromRight (10);
+    transferCurve.setBounds (display);
+    
+    area.removeFromTop (10);
+    
+    auto footer = area.removeFromBottom (24);
+    bypassButton   .setBounds (footer.removeFromLeft (100));
+    sidechainButton.setBounds (footer.removeFromLeft (120));
+    keyFilterButton.setBounds (footer.removeFromLeft (100));
+    adaptiveButton .setBounds (footer.removeFromLeft (140));
+   #if JUCE_MODULE_AVAILABLE_juce_opengl
+    openGLButton.setBounds (footer.removeFromRight (100));
+   #endif
+    storeButton.setBounds (footer.removeFromRight (60).reduced (4, 0));
+    presetBox  .setBounds (footer.removeFromRight (160));
+    
+    // Sliders on the left row, the combo boxes in two rows next to them
+    auto sliderRow = area.removeFromTop (area.getHeight() / 2);
+    juce::Slider* sliders[] = { &inputSlider, &thresholdSlider, &kneeSlider, &attackSlider, &releaseSlider, &outputSlider,
+                               &lookaheadSlider, &keyFrequencySlider, &rmsWindowSlider, &cpuBudgetSlider };
+    const auto sliderWidth = sliderRow.getWidth() / (int) std::size (sliders);
+    
+    for (size_t i = 0; i < std::size (sliders); ++i)
+    {
+        auto cell = sliderRow.removeFromLeft (sliderWidth);
+        labels[i].setBounds (cell.removeFromTop (16));
+        sliders[i]->setBounds (cell);
+    }
+    
+    juce::ComboBox* comboBoxes[] = { &ratioBox, &detectorBox, &engineBox, &gainRateBox, &linkBox, &oversamplingBox, &oversamplingFilterBox };
+    const auto comboBoxWidth = area.getWidth() / (int) std::size (comboBoxes);
+    
+    for (size_t i = 0; i < std::size (comboBoxes); ++i)
+    {
+        auto cell = area.removeFromLeft (comboBoxWidth).reduced (4, 0);
+        labels[std::size (sliders) + i].setBounds (cell.removeFromTop (16));
+        comboBoxes[i]->setBounds (cell.removeFromTop (24));
+    }
+}
+
+//==============================================================================
+void CompressorAudioProcessorEditor::timerCallback()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    const auto elapsedSeconds = (now - lastFrameTime) * 0.001;
+    lastFrameTime = now;
+    
+    // Every block since the last frame, merged into one
+    MeterFrame frame;
+    
+    if (audioProcessor.getMeterQueue().popAll (frame))
+        meter.setFrame (frame, elapsedSeconds);
+    else
+        meter.decay (elapsedSeconds);
+    
+    updateCurve();
+    updatePresetBox();
+}
+
+void CompressorAudioProcessorEditor::updateCurve()
+{
+    auto& treeState = audioProcessor.treeState;
+    
+    const auto thresholddB = treeState.getRawParameterValue (audioProcessor.paramThreshold)->load();
+    const auto ratioChoice = treeState.getRawParameterValue (audioProcessor.paramRatio)->load();
+    const auto kneedB      = treeState.getRawParameterValue (audioProcessor.paramKnee)->load();
+    
+    // Does nothing unless one of the values changed
+    transferCurve.setCurve (thresholddB, (float) Parameters::getRatioFromChoice ((int) ratioChoice), kneedB);
+}
+
+void CompressorAudioProcessorEditor::updatePresetBox()
+{
+    auto& presetBank = audioProcessor.getPresetBank();
+    
+    for (int i = 0; i < PresetBank::numPresets; ++i)
+    {
+        if (presetBox.getItemText (i) != presetBank.getName (i))
+        {
+            presetBox.clear (juce::dontSendNotification);
+            
+            for (int j = 0; j < PresetBank::numPresets; ++j)
+                presetBox.addItem (presetBank.getName (j), j + 1);
+            
+            break;
+        }
+    }
+    
+    if (presetBox.getSelectedItemIndex() != audioProcessor.getCurrentProgram())
+        presetBox.setSelectedItemIndex (audioProcessor.getCurrentProgram(), juce::dontSendNotification);
+}
+
+void CompressorAudioProcessorEditor::addSlider (juce::Slider& slider, juce::Label& label, const juce::String& parameterId)
+{
+    slider.setSliderStyle (juce::Slider::RotaryHorizontalVerticalDrag);
+    slider.setTextBoxStyle (juce::Slider::TextBoxBelow, false, 80, 18);
+    addAndMakeVisible (slider);
+    
+    label.setText (audioProcessor.treeState.getParameter (parameterId)->getName (32), juce::dontSendNotification);
+    label.setJustificationType (juce::Justification::centred);
+    addAndMakeVisible (label);
+    
+    sliderAttachments.push_back (std::make_unique<SliderAttachment> (audioProcessor.treeState, parameterId, slider));
+}
+
+void CompressorAudioProcessorEditor::addComboBox (juce::ComboBox& comboBox, juce::Label& label, const juce::String& parameterId)
+{
+    // The attachment doesn't add the items, they come from the parameter
+    if (auto* parameter = dynamic_cast<juce::AudioParameterChoice*> (audioProcessor.treeState.getParameter (parameterId)))
+        comboBox.addItemList (parameter->choices, 1);
+    
+    addAndMakeVisible (comboBox);
+    
+    label.setText (audioProcessor.treeState.getParameter (parameterId)->getName (32), juce::dontSendNotification);
+    label.setJustificationType (juce::Justification::centred);
+    addAndMakeVisible (label);
+    
+    comboBoxAttachments.push_back (std::make_unique<ComboBoxAttachment> (audioProcessor.treeState, parameterId, comboBox));
+}
+
+void CompressorAudioProcessorEditor::addButton (juce::ToggleButton& button, const juce::String& parameterId)
+{
+    addAndMakeVisible (button);
+    buttonAttachments.push_back (std::make_unique<ButtonAttachment> (audioProcessor.treeState, parameterId, button));
 }
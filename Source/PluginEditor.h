@@ -10,11 +10,20 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "UI/TransferCurve.h"
+#include "UI/GainReductionMeter.h"
 
 //==============================================================================
-/**
+/** The transfer curve, the meters and a control per parameter.
+
+    Nothing here repaints on its own. A single timer, capped at
+    maxFrameRate, drains the processor's MeterQueue and polls the
+    parameters the curve depends on, so an open editor costs the message
+    thread one short callback per frame whatever the block size, and the
+    curve is only rendered again when one of them changed.
 */
-class CompressorAudioProcessorEditor  : public juce::AudioProcessorEditor
+class CompressorAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                        private juce::Timer
 {
 public:
     CompressorAudioProcessorEditor (CompressorAudioProcessor&);
@@ -23,11 +32,54 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    
+    static constexpr int maxFrameRate = 30;
 
 private:
+    //==============================================================================
+    void timerCallback() override;
+    
+    void updateCurve();
+    
+    /** Refills the preset names and follows the host's program changes */
+    void updatePresetBox();
+    
+    void addSlider (juce::Slider& slider, juce::Label& label, const juce::String& parameterId);
+    void addComboBox (juce::ComboBox& comboBox, juce::Label& label, const juce::String& parameterId);
+    void addButton (juce::ToggleButton& button, const juce::String& parameterId);
+    
+    //==============================================================================
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     CompressorAudioProcessor& audioProcessor;
+    
+    TransferCurve transferCurve;
+    GainReductionMeter meter;
+    double lastFrameTime = 0.0;
+    
+    using SliderAttachment   = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment   = juce::AudioProcessorValueTreeState::ButtonAttachment;
+    
+    juce::Slider inputSlider, thresholdSlider, kneeSlider, attackSlider, releaseSlider, outputSlider, lookaheadSlider, keyFrequencySlider, rmsWindowSlider, cpuBudgetSlider;
+    juce::ComboBox ratioBox, detectorBox, engineBox, gainRateBox, linkBox, oversamplingBox, oversamplingFilterBox;
+    juce::ToggleButton bypassButton { "Bypass" }, sidechainButton { "External Key" }, keyFilterButton { "Key Filter" }, adaptiveButton { "Adaptive Quality" };
+    
+    juce::ComboBox presetBox;
+    juce::TextButton storeButton { "Store" };
+    
+    // One label per slider and combo box, in the order they're laid out
+    std::array<juce::Label, 17> labels;
+    
+    std::vector<std::unique_ptr<SliderAttachment>> sliderAttachments;
+    std::vector<std::unique_ptr<ComboBoxAttachment>> comboBoxAttachments;
+    std::vector<std::unique_ptr<ButtonAttachment>> buttonAttachments;
+    
+   #if JUCE_MODULE_AVAILABLE_juce_opengl
+    // Optional, moves the painting of this editor onto the GPU
+    juce::OpenGLContext openGLContext;
+    juce::ToggleButton openGLButton { "OpenGL" };
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorAudioProcessorEditor)
 };
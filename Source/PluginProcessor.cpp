@@ -16,10 +16,11 @@ CompressorAudioProcessor::CompressorAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       ), treeState(*this, nullptr, "PARAMS", createParameterLayout())
+                       ), treeState(*this, nullptr, "PARAMS", Parameters::createParameterLayout())
 #endif
 {
     treeState.addParameterListener(paramInput, this);
@@ -29,10 +30,36 @@ CompressorAudioProcessor::CompressorAudioProcessor()
     treeState.addParameterListener(paramRelease, this);
     treeState.addParameterListener(paramOutput, this);
     treeState.addParameterListener(paramBypass, this);
+    treeState.addParameterListener(paramEngine, this);
+    treeState.addParameterListener(paramGainRate, this);
+    treeState.addParameterListener(paramLink, this);
+    treeState.addParameterListener(paramLookahead, this);
+    treeState.addParameterListener(paramOversampling, this);
+    treeState.addParameterListener(paramOversamplingFilter, this);
+    treeState.addParameterListener(paramSidechain, this);
+    treeState.addParameterListener(paramKeyFilter, this);
+    treeState.addParameterListener(paramKeyFrequency, this);
+    treeState.addParameterListener(paramDetector, this);
+    treeState.addParameterListener(paramRmsWindow, this);
+    treeState.addParameterListener(paramKnee, this);
+    treeState.addParameterListener(paramAdaptiveQuality, this);
+    treeState.addParameterListener(paramCpuBudget, this);
+    
+    floatChannelStrip.setRampDurationSeconds(parameterRampSeconds);
+    doubleChannelStrip.setRampDurationSeconds(parameterRampSeconds);
+    
+    startTimerHz(statusPollHz);
 }
 
 CompressorAudioProcessor::~CompressorAudioProcessor()
 {
+    stopTimer();
+    
+   #if COMPRESSOR_ENABLE_TRACING
+    // Hosts may delete an instance without releasing it first
+    stopTracing();
+   #endif
+    
     treeState.removeParameterListener(paramInput, this);
     treeState.removeParameterListener(paramRatio, this);
     treeState.removeParameterListener(paramThreshold, this);
@@ -40,6 +67,20 @@ CompressorAudioProcessor::~CompressorAudioProcessor()
     treeState.removeParameterListener(paramRelease, this);
     treeState.removeParameterListener(paramOutput, this);
     treeState.removeParameterListener(paramBypass, this);
+    treeState.removeParameterListener(paramEngine, this);
+    treeState.removeParameterListener(paramGainRate, this);
+    treeState.removeParameterListener(paramLink, this);
+    treeState.removeParameterListener(paramLookahead, this);
+    treeState.removeParameterListener(paramOversampling, this);
+    treeState.removeParameterListener(paramOversamplingFilter, this);
+    treeState.removeParameterListener(paramSidechain, this);
+    treeState.removeParameterListener(paramKeyFilter, this);
+    treeState.removeParameterListener(paramKeyFrequency, this);
+    treeState.removeParameterListener(paramDetector, this);
+    treeState.removeParameterListener(paramRmsWindow, this);
+    treeState.removeParameterListener(paramKnee, this);
+    treeState.removeParameterListener(paramAdaptiveQuality, this);
+    treeState.removeParameterListener(paramCpuBudget, this);
 }
 
 //==============================================================================
@@ -77,56 +118,139 @@ bool CompressorAudioProcessor::isMidiEffect() const
 
 double CompressorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The lookahead and the oversampling filters keep the output going after
+    // the input stops
+    const auto sampleRate = getSampleRate();
+    return sampleRate > 0.0 ? latencySamples.load() / sampleRate : 0.0;
 }
 
 int CompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return PresetBank::numPresets;
 }
 
 int CompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentPreset;
 }
 
 void CompressorAudioProcessor::setCurrentProgram (int index)
 {
+    index = juce::jlimit (0, PresetBank::numPresets - 1, index);
+    currentPreset = index;
+    
+    ++parametersHeld;
+    ++parametersGeneration;
+    Parameters::setValues (treeState, presetBank.getValues (index));
+    pendingPreset = index;
+    ++parametersGeneration;
+    --parametersHeld;
 }
 
 const juce::String CompressorAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetBank.getName (index);
 }
 
 void CompressorAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    presetBank.setName (index, newName);
+}
+
+void CompressorAudioProcessor::storePreset (int index)
+{
+    index = juce::jlimit (0, PresetBank::numPresets - 1, index);
+    currentPreset = index;
+    presetBank.store (index, Parameters::getValues (treeState));
 }
 
 //==============================================================================
 void CompressorAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    // Preset coefficients depend on the rate
+    presetBank.prepare(sampleRate);
+    
+   #if COMPRESSOR_ENABLE_TRACING
+    // Once per instance, however often the host prepares it
+    if (! isTracing)
+        Tracing::prepare();
+    
+    isTracing = true;
+    Tracing::setDeadline(samplesPerBlock, sampleRate);
+   #endif
+    
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
     spec.numChannels = getTotalNumOutputChannels();
     spec.maximumBlockSize = samplesPerBlock;
     
-    inputGain.prepare(spec);
-    inputGain.setGainDecibels(0.0);
+    // Apply the parameters before preparing, so the gains start at their
+    // values instead of ramping to them
+    parametersChanged = false;
+    requestedParameters = Parameters::readSnapshot(treeState);
+    appliedParameters = requestedParameters;
+    
+    // Every session starts at full quality
+    adaptiveQuality.prepare(sampleRate);
+    adaptiveQuality.setEnabled(requestedParameters.adaptiveQuality);
+    adaptiveQuality.setBudget(requestedParameters.cpuBudget);
+    adaptiveQuality.setUsefulLevels(Parameters::getUsefulQualityLevels(requestedParameters));
+    appliedQualityLevel = AdaptiveQuality::full;
+    
+    if (isUsingDoublePrecision()){
+        Parameters::applySnapshot(doubleChannelStrip, appliedParameters, appliedParameters, true);
+        doubleChannelStrip.setMeteringEnabled(true);
+        doubleChannelStrip.prepare(spec);
+    } else {
+        Parameters::applySnapshot(floatChannelStrip, appliedParameters, appliedParameters, true);
+        floatChannelStrip.setMeteringEnabled(true);
+        floatChannelStrip.prepare(spec);
+    }
     
-    outputGain.prepare(spec);
-    outputGain.setGainDecibels(0.0);
+    // The host asks for the latency right after this returns, so set it now
+    latencySamples = isUsingDoublePrecision() ? doubleChannelStrip.getLatencySamples()
+                                              : floatChannelStrip.getLatencySamples();
+    setLatencySamples(latencySamples);
     
-    compressor.prepare(spec);
+    qualityLevel = AdaptiveQuality::full;
 }
 
 void CompressorAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    
+   #if COMPRESSOR_ENABLE_TRACING
+    stopTracing();
+   #endif
 }
 
+#if COMPRESSOR_ENABLE_TRACING
+void CompressorAudioProcessor::stopTracing()
+{
+    if (! isTracing)
+        return;
+    
+    isTracing = false;
+    
+    // The trace is shared by every instance in the process, so only the last
+    // one to stop writes it: everything since the last time it was written,
+    // for chrome://tracing or ui.perfetto.dev
+    if (! Tracing::release())
+        return;
+    
+    const auto traceFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("CompressorTrace.json");
+    
+    if (juce::FileOutputStream stream (traceFile); stream.openedOk()){
+        stream.setPosition(0);
+        stream.truncate();
+        Tracing::writeChromeTrace(stream);
+    }
+    
+    Tracing::clear();
+}
+#endif
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -134,12 +258,12 @@ bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any channel set works, mono and stereo through surround, immersive and
+    // ambisonic buses. The compressor packs the channels into SIMD lanes
+    // whatever their number. The key is off unless the host enables it, and
+    // can be any channel set too, one that doesn't match the main bus is
+    // folded into one detector signal.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -153,8 +277,12 @@ bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 }
 #endif
 
-void CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+template <typename SampleType>
+void CompressorAudioProcessor::processBlockInternal (juce::AudioBuffer<SampleType>& buffer)
 {
+    COMPRESSOR_TRACE_BLOCK();
+    const auto blockStart = juce::Time::getHighResolutionTicks();
+    
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -162,87 +290,148 @@ void CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    juce::dsp::AudioBlock<float> block { buffer };
+    // Views into the host's buffer, the key is read from it in place
+    auto mainBuffer = getBusBuffer (buffer, false, 0);
+    auto keyBuffer  = getBusCount (true) > 1 ? getBusBuffer (buffer, true, 1) : juce::AudioBuffer<SampleType>();
     
-//    if (isBypassed){
-//        return;
-//    }
+    // A preset takes over from the parameters for this block, the values the
+    // tree state was moved to then match it
+    {
+        COMPRESSOR_TRACE_STAGE("parameters");
+        auto parametersRead = false;
     
-    inputGain.process(juce::dsp::ProcessContextReplacing<float> (block));
-    compressor.process(juce::dsp::ProcessContextReplacing<float> (block));
-    outputGain.process(juce::dsp::ProcessContextReplacing<float> (block));
-}
-
-
-
-juce::AudioProcessorValueTreeState::ParameterLayout CompressorAudioProcessor::createParameterLayout(){
-    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
-    
-    auto inputdB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("INPUT", 1), "Input", juce::NormalisableRange<float>(-10.0f, 10.0f), 0.0f);
+        if (const auto presetIndex = pendingPreset.exchange(-1); presetIndex >= 0){
+            if (presetBank.apply(presetIndex, getChannelStrip<SampleType>(), appliedParameters)){
+                requestedParameters = appliedParameters;
+                parametersRead = true;
+                updateLatency<SampleType>();
+            } else {
+                // The bank is being edited, try again next block unless another
+                // preset was selected in the meantime
+                auto none = -1;
+                pendingPreset.compare_exchange_strong(none, presetIndex);
+            }
+        } else if (parametersChanged.exchange(false)){
+            // A selection that starts after the generation is loaded moves it,
+            // one that started before is still held or has moved it since
+            const auto generation = parametersGeneration.load();
+            
+            if (parametersHeld == 0){
+                const auto snapshot = Parameters::readSnapshot(treeState);
+                
+                if (parametersGeneration.load() == generation){
+                    requestedParameters = snapshot;
+                    parametersRead = true;
+                }
+            }
+            
+            if (! parametersRead)
+                parametersChanged = true;
+        }
+        
+        if (parametersRead){
+            adaptiveQuality.setEnabled(requestedParameters.adaptiveQuality);
+            adaptiveQuality.setBudget(requestedParameters.cpuBudget);
+            adaptiveQuality.setUsefulLevels(Parameters::getUsefulQualityLevels(requestedParameters));
+        }
+        
+        // What the parameters say, minus what the quality level gives up
+        const auto level = adaptiveQuality.getLevel();
+        
+        if (parametersRead || level != appliedQualityLevel){
+            const auto snapshot = Parameters::withQualityLevel(requestedParameters, level);
+            Parameters::applySnapshot(getChannelStrip<SampleType>(), snapshot, appliedParameters, false);
+            appliedParameters = snapshot;
+            appliedQualityLevel = level;
+            updateLatency<SampleType>();
+        }
+        
+        // Posting a message could lock or allocate, timerCallback() picks the
+        // level up instead
+        if (qualityLevel.exchange(level) != level){
+            COMPRESSOR_TRACE_INSTANT("quality level");
+        }
+    }
     
-    const juce::StringArray choices {"4:1", "8:1", "12:1", "20:1"};
-    auto ratio = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID("RATIO", 1), "Ratio", choices, 0);
+    juce::dsp::AudioBlock<SampleType> block { mainBuffer };
     
-    auto thresholddB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("THRESHOLD", 1), "Threshold", juce::NormalisableRange<float>(-60.0f, 10.0f), 0.0f);
+    juce::dsp::AudioBlock<const SampleType> keyBlock;
     
-    // attack in MICROSECONDS
-    auto attackTime = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("ATTACK", 1), "Attack", juce::NormalisableRange<float>(20.0f, 800.0f, 0.5f), 400.0f);
+    if (appliedParameters.useSidechain && keyBuffer.getNumChannels() > 0)
+        keyBlock = juce::dsp::AudioBlock<const SampleType> (keyBuffer);
     
-    // release in MS
-    auto releaseTime = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("RELEASE", 1), "Release", juce::NormalisableRange<float>(50.0f, 1100.0f, 0.5f), 250.0f);
+    // input gain -> compressor -> output gain, in a single pass. Bypass is
+    // part of the snapshot, the strip crossfades to its latency matched dry
+    // signal
+    {
+        COMPRESSOR_TRACE_STAGE("channel strip");
+        getChannelStrip<SampleType>().process(juce::dsp::ProcessContextReplacing<SampleType> (block), keyBlock);
+    }
     
-    auto bypass = std::make_unique<juce::AudioParameterBool>(juce::ParameterID("BYPASS", 1), "Bypass", false);
+    // Lock free, if the editor isn't reading the frame is simply dropped. The
+    // strip measures at the host's rate, whatever the oversampling.
+    {
+        COMPRESSOR_TRACE_STAGE("metering");
+        auto& channelStrip = getChannelStrip<SampleType>();
+        meterQueue.push(MeterFrame::fromLevels<SampleType>(channelStrip.getLevels()));
+        channelStrip.resetLevels();
+    }
     
-    auto outputdB = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID("OUTPUT", 1), "Output", juce::NormalisableRange<float>(-10.0f, 10.0f), 0.0f);
+    // The level it leads to applies from the next block
+    const auto blockSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStart);
+    adaptiveQuality.addMeasurement(blockSeconds, buffer.getNumSamples());
+}
+
+template <typename SampleType>
+void CompressorAudioProcessor::updateLatency()
+{
+    // Posting a message could lock or allocate, timerCallback() reports it
+    latencySamples = getChannelStrip<SampleType>().getLatencySamples();
+}
+
+void CompressorAudioProcessor::timerCallback()
+{
+    if (const auto latency = latencySamples.load(); latency != getLatencySamples())
+        setLatencySamples(latency);
     
-    params.push_back(std::move(inputdB));
-    params.push_back(std::move(ratio));
-    params.push_back(std::move(thresholddB));
-    params.push_back(std::move(attackTime));
-    params.push_back(std::move(releaseTime));
-    params.push_back(std::move(bypass));
-    params.push_back(std::move(outputdB));
+    // Nothing else sets the quality level parameter
+    if (auto* parameter = treeState.getParameter(paramQualityLevel)){
+        const auto value = parameter->convertTo0to1(static_cast<float>(qualityLevel.load()));
+        
+        if (parameter->getValue() != value)
+            parameter->setValueNotifyingHost(value);
+    }
+}
+
+void CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processBlockInternal(buffer);
+}
+
+void CompressorAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processBlockInternal(buffer);
+}
+
+bool CompressorAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
 
-    return { params.begin(), params.end() };
+juce::AudioProcessorParameter* CompressorAudioProcessor::getBypassParameter() const
+{
+    return treeState.getParameter(paramBypass);
 }
 
 void CompressorAudioProcessor::parameterChanged(const juce::String& parameterId, float newValue) {
-    if (parameterId == paramInput){
-        inputGain.setGainDecibels(newValue);
-    }
-    else if (parameterId == paramRatio){
-        int ratio = 4;
-        switch (static_cast<int>(newValue)) {
-            case RatioChoice::Four:
-                ratio = 4;
-                break;
-            case RatioChoice::Eight:
-                ratio = 8;
-                break;
-            case RatioChoice::Twelve:
-                ratio = 12;
-                break;
-            case RatioChoice::Twenty:
-                ratio = 20;
-                break;
-        }
-        compressor.setRatio(ratio);
-    }
-    else if (parameterId == paramThreshold){
-        compressor.setThreshold(newValue);
-    }
-    else if (parameterId == paramAttack){
-        compressor.setAttack(newValue);
-    }
-    else if (parameterId == paramRelease){
-        compressor.setRelease(newValue);
-    }
-    else if (parameterId == paramOutput){
-        outputGain.setGainDecibels(newValue);
-    }
-    else if (parameterId == paramBypass){
-        isBypassed = treeState.getRawParameterValue(paramBypass);
-    }
+    juce::ignoreUnused (parameterId, newValue);
+    
+    // May be called from any thread: the values are picked up by the audio
+    // thread at the start of the next block
+    COMPRESSOR_TRACE_INSTANT("parameterChanged");
+    parametersChanged = true;
 }
 
 //==============================================================================
@@ -253,22 +442,38 @@ bool CompressorAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* CompressorAudioProcessor::createEditor()
 {
-//    return new CompressorAudioProcessorEditor (*this);
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new CompressorAudioProcessorEditor (*this);
 }
 
 //==============================================================================
 void CompressorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    juce::MemoryOutputStream stream (destData, false);
+    
+    stream.writeInt (stateMagic);
+    stream.writeInt (stateVersion);
+    Parameters::writeValues (treeState, Parameters::getValues (treeState), stream);
+    stream.writeCompressedInt (currentPreset.load());
+    presetBank.write (stream);
 }
 
 void CompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    juce::MemoryInputStream stream (data, static_cast<size_t> (juce::jmax (0, sizeInBytes)), false);
+    
+    // Versions newer than this one may have changed the layout of the block
+    if (stream.readInt() != stateMagic || stream.readInt() > stateVersion)
+        return;
+    
+    Parameters::Values values;
+    
+    if (! Parameters::readValues (treeState, stream, values))
+        return;
+    
+    Parameters::setValues (treeState, values);
+    
+    currentPreset = juce::jlimit (0, PresetBank::numPresets - 1, stream.readCompressedInt());
+    presetBank.read (stream);
 }
 
 //==============================================================================
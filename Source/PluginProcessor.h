@@ -9,15 +9,17 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Processing/Compressor.h"
-
-enum RatioChoice { Four, Eight, Twelve, Twenty };
+#include "Parameters.h"
+#include "PresetBank.h"
+#include "Processing/Metering.h"
+#include "Processing/Tracing.h"
 
 //==============================================================================
 /**
 */
 class CompressorAudioProcessor  : public juce::AudioProcessor,
-                                  public juce::AudioProcessorValueTreeState::Listener
+                                  public juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::Timer
 {
 public:
     //==============================================================================
@@ -33,6 +35,13 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    bool supportsDoublePrecisionProcessing() const override;
+    
+    /** The BYPASS parameter, so hosts bypass through the strip's latency
+        matched crossfade instead of processBlockBypassed() */
+    juce::AudioProcessorParameter* getBypassParameter() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -59,25 +68,129 @@ public:
     
     juce::AudioProcessorValueTreeState treeState;
     
-    juce::String paramInput { "INPUT" };
-    juce::String paramRatio { "RATIO" };
-    juce::String paramThreshold { "THRESHOLD" };
-    juce::String paramAttack { "ATTACK" };
-    juce::String paramRelease { "RELEASE" };
-    juce::String paramOutput { "OUTPUT" };
-    juce::String paramBypass { "BYPASS" };
+    /** One MeterFrame per processed block, read by the editor */
+    MeterQueue& getMeterQueue() { return meterQueue; }
+    
+    /** The host's programs. setCurrentProgram() moves the parameters to a
+        preset and has the audio thread switch to it at the next block. */
+    PresetBank& getPresetBank() { return presetBank; }
+    
+    /** Stores the current parameter values into a preset */
+    void storePreset (int index);
+    
+    juce::String paramInput { Parameters::inputID };
+    juce::String paramRatio { Parameters::ratioID };
+    juce::String paramThreshold { Parameters::thresholdID };
+    juce::String paramAttack { Parameters::attackID };
+    juce::String paramRelease { Parameters::releaseID };
+    juce::String paramOutput { Parameters::outputID };
+    juce::String paramBypass { Parameters::bypassID };
+    juce::String paramEngine { Parameters::engineID };
+    juce::String paramGainRate { Parameters::gainRateID };
+    juce::String paramLink { Parameters::linkID };
+    juce::String paramLookahead { Parameters::lookaheadID };
+    juce::String paramOversampling { Parameters::oversamplingID };
+    juce::String paramOversamplingFilter { Parameters::oversamplingFilterID };
+    juce::String paramSidechain { Parameters::sidechainID };
+    juce::String paramKeyFilter { Parameters::keyFilterID };
+    juce::String paramKeyFrequency { Parameters::keyFrequencyID };
+    juce::String paramDetector { Parameters::detectorID };
+    juce::String paramRmsWindow { Parameters::rmsWindowID };
+    juce::String paramKnee { Parameters::kneeID };
+    juce::String paramAdaptiveQuality { Parameters::adaptiveQualityID };
+    juce::String paramCpuBudget { Parameters::cpuBudgetID };
+    juce::String paramQualityLevel { Parameters::qualityLevelID };
 
 private:
     
     //==============================================================================
-    juce::dsp::Gain<float> inputGain, outputGain;
+    // One strip per precision, only the one matching the host's processing
+    // precision is prepared and used
+    ChannelStrip<float> floatChannelStrip;
+    ChannelStrip<double> doubleChannelStrip;
+    
+    // How long the gains and the threshold take to reach a new value, so
+    // automating them doesn't zipper
+    static constexpr double parameterRampSeconds = 0.05;
+    
+    template <typename SampleType>
+    ChannelStrip<SampleType>& getChannelStrip() {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleChannelStrip;
+        else
+            return floatChannelStrip;
+    }
+    
+    template <typename SampleType>
+    void processBlockInternal (juce::AudioBuffer<SampleType>& buffer);
+    
+    MeterQueue meterQueue;
+    
+    //==============================================================================
+    /** Selecting a preset holds the audio thread off the parameters while
+        they're moved to it, then leaves its index in pendingPreset. The audio
+        thread switches the strip to the preset's precomputed state in one go,
+        so it never sees a mix of old and new values. parametersHeld counts
+        the selections in progress, the host and the editor can overlap.
+        parametersGeneration moves when one starts and when it ends, so a
+        snapshot read while it changed is dropped and read again next block. */
+    PresetBank presetBank { treeState };
+    std::atomic<int> pendingPreset { -1 };
+    std::atomic<int> parametersHeld { 0 };
+    std::atomic<juce::uint32> parametersGeneration { 0 };
+    std::atomic<int> currentPreset { 0 };
     
-    Compressor<float> compressor;
+    // The state is a magic number, the version, the values of the
+    // parameters, the current preset and the bank
+    static constexpr int stateMagic = 0x52504d43;    // "CMPR"
+    static constexpr int stateVersion = 1;
     
-    bool isBypassed = false;
+    //==============================================================================
+    /** The parameter values used by the DSP, read from the tree state once per
+        block on the audio thread. parameterChanged() may run on any thread, so
+        it only raises parametersChanged; the audio thread then reads a fresh
+        snapshot next to the one it last applied and forwards the fields that
+        differ, so the coefficients are recomputed at most once per block. */
+    Parameters::Snapshot appliedParameters;
+    std::atomic<bool> parametersChanged { true };
+    
+    //==============================================================================
+    /** Adaptive quality. Every block is timed, and when the level changes the
+        strip is moved to requestedParameters (what the parameters say) with
+        that level applied, see Parameters::withQualityLevel(). The audio
+        thread only stores the level in qualityLevel, the host sees it through
+        a read-only parameter that timerCallback() keeps up to date. */
+    AdaptiveQuality adaptiveQuality;
+    Parameters::Snapshot requestedParameters;
+    AdaptiveQuality::Level appliedQualityLevel = AdaptiveQuality::full;
+    std::atomic<int> qualityLevel { AdaptiveQuality::full };
 
     //==============================================================================
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    /** The latency of the DSP, from the lookahead and the oversampling
+        filters. The audio thread only stores it, timerCallback() reports a
+        change to the host from the message thread. */
+    std::atomic<int> latencySamples { 0 };
+    
+    template <typename SampleType>
+    void updateLatency();
+    
+    /** How often the message thread looks for a new latency and quality
+        level */
+    static constexpr int statusPollHz = 10;
+    
+    void timerCallback() override;
+    
+   #if COMPRESSOR_ENABLE_TRACING
+    //==============================================================================
+    /** Whether this instance counts as a user of the process-wide trace, see
+        Tracing::prepare(). stopTracing() counts it out, and writes the trace
+        when it was the last. */
+    bool isTracing = false;
+    
+    void stopTracing();
+   #endif
+    
+    //==============================================================================
     void parameterChanged(const juce::String& parameterId, float newValue) override;
     
     //==============================================================================
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Created: 16 Oct 2026 7:35:58pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+PresetBank::PresetBank(const juce::AudioProcessorValueTreeState& state)
+    : treeState (state){
+    const auto defaults = Parameters::getDefaultValues(treeState);
+
+    for (size_t i = 0; i < presets.size(); ++i)
+    {
+        presets[i].name   = "Preset " + juce::String(i + 1);
+        presets[i].values = defaults;
+        update(presets[i]);
+    }
+}
+
+//==============================================================================
+const juce::String& PresetBank::getName(int index) const{
+    return presets[static_cast<size_t>(juce::jlimit(0, numPresets - 1, index))].name;
+}
+
+void PresetBank::setName(int index, const juce::String& newName){
+    const juce::SpinLock::ScopedLockType sl (lock);
+    presets[static_cast<size_t>(juce::jlimit(0, numPresets - 1, index))].name = newName;
+}
+
+const Parameters::Values& PresetBank::getValues(int index) const{
+    return presets[static_cast<size_t>(juce::jlimit(0, numPresets - 1, index))].values;
+}
+
+void PresetBank::store(int index, const Parameters::Values& values){
+    // Computed outside the lock, so the audio thread is kept out only for the copy
+    Preset preset;
+    preset.name   = getName(index);
+    preset.values = values;
+    update(preset);
+
+    const juce::SpinLock::ScopedLockType sl (lock);
+    presets[static_cast<size_t>(juce::jlimit(0, numPresets - 1, index))] = std::move(preset);
+}
+
+void PresetBank::prepare(double newSampleRate){
+    const juce::SpinLock::ScopedLockType sl (lock);
+    sampleRate = newSampleRate;
+
+    for (auto& preset : presets)
+        update(preset);
+}
+
+//==============================================================================
+void PresetBank::write(juce::OutputStream& stream) const{
+    stream.writeCompressedInt(numPresets);
+
+    for (const auto& preset : presets)
+    {
+        stream.writeString(preset.name);
+        Parameters::writeValues(treeState, preset.values, stream);
+    }
+}
+
+bool PresetBank::read(juce::InputStream& stream){
+    const auto numStored = stream.readCompressedInt();
+
+    for (int i = 0; i < numStored; ++i)
+    {
+        if (stream.isExhausted())
+            return false;
+
+        const auto name = stream.readString();
+        Parameters::Values values;
+
+        if (! Parameters::readValues(treeState, stream, values))
+            return false;
+
+        // A bank from a version with more slots loses the extra ones
+        if (i < numPresets)
+        {
+            setName(i, name);
+            store(i, values);
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+template <typename SampleType>
+bool PresetBank::apply(int index, ChannelStrip<SampleType>& channelStrip, Parameters::Snapshot& applied){
+    const juce::SpinLock::ScopedTryLockType sl (lock);
+
+    if (! sl.isLocked())
+        return false;
+
+    const auto& preset = presets[static_cast<size_t>(juce::jlimit(0, numPresets - 1, index))];
+
+    if constexpr (std::is_same_v<SampleType, double>)
+        Parameters::applySnapshot(channelStrip, preset.snapshot, applied, false, &preset.doubleCoefficients);
+    else
+        Parameters::applySnapshot(channelStrip, preset.snapshot, applied, false, &preset.floatCoefficients);
+
+    applied = preset.snapshot;
+    return true;
+}
+
+void PresetBank::update(Preset& preset) const{
+    // Through the parameters' own rounding, so the tree state holds exactly
+    // these values after a switch and the next snapshot finds nothing to change
+    const auto& parameters = treeState.processor.getParameters();
+
+    for (int i = 0; i < parameters.size() && i < static_cast<int>(preset.values.size()); ++i)
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[i]))
+            preset.values[static_cast<size_t>(i)] = ranged->convertFrom0to1(ranged->convertTo0to1(preset.values[static_cast<size_t>(i)]));
+
+    preset.snapshot           = Parameters::readSnapshot(treeState, preset.values);
+    preset.floatCoefficients  = Parameters::makeCoefficients<float>(preset.snapshot, sampleRate);
+    preset.doubleCoefficients = Parameters::makeCoefficients<double>(preset.snapshot, sampleRate);
+}
+
+//==============================================================================
+template bool PresetBank::apply<float>  (int, ChannelStrip<float>&,  Parameters::Snapshot&);
+template bool PresetBank::apply<double> (int, ChannelStrip<double>&, Parameters::Snapshot&);
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Created: 16 Oct 2026 7:35:58pm
+    Author:  Chris
+
+    A fixed number of presets kept in memory, each a full set of parameter
+    values. Next to the values, every preset keeps its Snapshot and the
+    compressor coefficients for both precisions, computed on the message
+    thread whenever the preset or the sample rate changes. Switching to a
+    preset on the audio thread then only copies values into the strip: no
+    allocation, and no Compressor::update().
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Parameters.h"
+
+class PresetBank {
+public:
+    //==============================================================================
+    static constexpr int numPresets = 8;
+
+    /** Fills every slot with the default values of the layout */
+    explicit PresetBank (const juce::AudioProcessorValueTreeState& treeState);
+
+    //==============================================================================
+    // Message thread only
+
+    const juce::String& getName (int index) const;
+    void setName (int index, const juce::String& newName);
+
+    const Parameters::Values& getValues (int index) const;
+
+    /** Replaces the values of a preset and recomputes what it precomputes */
+    void store (int index, const Parameters::Values& values);
+
+    /** Recomputes the coefficients of every preset for a strip running at
+        newSampleRate */
+    void prepare (double newSampleRate);
+
+    /** Writes the name and the values of every preset */
+    void write (juce::OutputStream& stream) const;
+
+    /** Reads what write() wrote. Returns false if the block is truncated,
+        the presets read until then are kept. */
+    bool read (juce::InputStream& stream);
+
+    //==============================================================================
+    /** Audio thread. Moves the strip to a preset, as applySnapshot would,
+        and sets applied to its snapshot. Returns false, without touching
+        anything, while the message thread is changing the bank: try again
+        on the next block. */
+    template <typename SampleType>
+    bool apply (int index, ChannelStrip<SampleType>& channelStrip, Parameters::Snapshot& applied);
+
+private:
+    //==============================================================================
+    struct Preset {
+        juce::String name;
+        Parameters::Values values;
+        Parameters::Snapshot snapshot;
+        Compressor<float>::Coefficients floatCoefficients;
+        Compressor<double>::Coefficients doubleCoefficients;
+    };
+
+    void update (Preset& preset) const;
+
+    const juce::AudioProcessorValueTreeState& treeState;
+    std::array<Preset, numPresets> presets;
+    double sampleRate = 44100.0;
+
+    // Held by the message thread while it changes a preset, the audio thread
+    // only ever tries it
+    juce::SpinLock lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    AdaptiveQuality.cpp
+    Created: 16 Oct 2026 7:49:53pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "AdaptiveQuality.h"
+
+void AdaptiveQuality::prepare(double newSampleRate){
+    jassert (newSampleRate > 0);
+
+    sampleRate  = newSampleRate;
+    averageLoad = 0.0;
+    stepUpWait  = stepUpSeconds;
+    setLevel (full);
+}
+
+void AdaptiveQuality::setEnabled(bool shouldBeEnabled){
+    enabled = shouldBeEnabled;
+
+    if (! enabled)
+        setLevel (full);
+}
+
+void AdaptiveQuality::setBudget(double newBudget){
+    jassert (newBudget > 0.0);
+    budget = newBudget;
+}
+
+void AdaptiveQuality::setUsefulLevels(juce::uint32 newLevelMask){
+    usefulLevels = newLevelMask | (1u << full);
+}
+
+bool AdaptiveQuality::addMeasurement(double seconds, int numSamples){
+    if (! enabled || numSamples <= 0)
+        return false;
+
+    const auto blockSeconds = numSamples / sampleRate;
+    const auto load = seconds / blockSeconds;
+
+    // One pole average over loadAverageSeconds of audio, whatever the block size
+    const auto weight = 1.0 - std::exp (-blockSeconds / loadAverageSeconds);
+    averageLoad += weight * (load - averageLoad);
+
+    secondsSinceChange  += blockSeconds;
+    secondsWithHeadroom  = averageLoad < budget * headroomFraction ? secondsWithHeadroom + blockSeconds : 0.0;
+
+    // A step up that held, the next one needn't wait any longer than the first
+    if (steppedUp && secondsSinceChange >= stepUpSeconds)
+    {
+        steppedUp  = false;
+        stepUpWait = stepUpSeconds;
+    }
+
+    if (secondsSinceChange < holdSeconds)
+        return false;
+
+    if (const auto levelDown = getNextLevelDown(); averageLoad > budget && levelDown >= 0)
+    {
+        if (steppedUp)
+            stepUpWait = juce::jmin (stepUpWait * 2.0, maxStepUpSeconds);
+
+        setLevel (levelDown);
+        return true;
+    }
+
+    if (const auto levelUp = getNextLevelUp(); secondsWithHeadroom >= stepUpWait && levelUp >= 0)
+    {
+        setLevel (levelUp);
+        steppedUp = true;
+        return true;
+    }
+
+    return false;
+}
+
+void AdaptiveQuality::setLevel(int newLevel){
+    level = static_cast<Level> (newLevel);
+    secondsSinceChange  = 0.0;
+    secondsWithHeadroom = 0.0;
+    steppedUp = false;
+}
+
+int AdaptiveQuality::getNextLevelDown() const{
+    for (int newLevel = level + 1; newLevel < numLevels; ++newLevel)
+        if ((usefulLevels & (1u << newLevel)) != 0)
+            return newLevel;
+
+    return -1;
+}
+
+int AdaptiveQuality::getNextLevelUp() const{
+    for (int newLevel = level - 1; newLevel >= full; --newLevel)
+        if ((usefulLevels & (1u << newLevel)) != 0)
+            return newLevel;
+
+    return -1;
+}
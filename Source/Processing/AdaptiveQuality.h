@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    AdaptiveQuality.h
+    Created: 16 Oct 2026 7:49:53pm
+    Author:  Chris
+
+    Trades precision for time when the audio thread runs out of it. Every
+    block reports how long it took, as a fraction of the time its samples
+    last (the load). While the average load stays above the budget, the
+    level steps down to cheaper processing, one level at a time. Once it
+    has stayed well below the budget for a while, the level steps back up.
+
+    The levels only say what to give up, see Parameters::withQualityLevel()
+    for how they map onto the parameters. Each level keeps the savings of
+    the ones above it. Levels that save nothing with the current parameters
+    are stepped over.
+
+    A step up that has to step down again soon after failed, and the next
+    one waits twice as long, so a load right at the budget doesn't flap
+    between two levels.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class AdaptiveQuality {
+public:
+    //==============================================================================
+    enum Level {
+        full,              // as the parameters say
+        fastGain,          // the approximate gain computer
+        controlRate,       // the gain computed on every 8th sample at most
+        noOversampling,    // the compressor at the base rate
+        numLevels
+    };
+
+    //==============================================================================
+    /** Resets to full quality */
+    void prepare (double newSampleRate);
+
+    /** Off, the level stays at full */
+    void setEnabled (bool shouldBeEnabled);
+
+    /** The load above which the level steps down, as a fraction of the
+        duration of a block, e.g. 0.7 */
+    void setBudget (double newBudget);
+
+    /** The levels that save anything over the one above them, one bit per
+        level. The others are stepped over, full always counts. */
+    void setUsefulLevels (juce::uint32 newLevelMask);
+
+    /** Reports the wall clock time one block of numSamples took to process.
+        Returns true when the level changed, the new level applies from the
+        next block. Audio thread only, doesn't allocate or lock. */
+    bool addMeasurement (double seconds, int numSamples);
+
+    Level getLevel () const { return level; }
+
+    /** The load, averaged over loadAverageSeconds */
+    double getAverageLoad () const { return averageLoad; }
+
+    //==============================================================================
+    /** How much audio the load is averaged over */
+    static constexpr double loadAverageSeconds = 0.1;
+
+    /** After a change, how long the level holds, so the average can show
+        what the change bought before the next one */
+    static constexpr double holdSeconds = 0.25;
+
+    /** The load has to stay below headroomFraction of the budget for
+        stepUpSeconds before the level steps up. A step up failed when the
+        level steps down again within stepUpSeconds, then the wait doubles,
+        up to maxStepUpSeconds. A step up that holds resets it. */
+    static constexpr double headroomFraction = 0.5;
+    static constexpr double stepUpSeconds = 2.0;
+    static constexpr double maxStepUpSeconds = 32.0;
+
+private:
+    //==============================================================================
+    void setLevel (int newLevel);
+
+    /** The next useful level below or above the current one, or -1 */
+    int getNextLevelDown () const;
+    int getNextLevelUp () const;
+
+    double sampleRate = 44100.0, budget = 0.7;
+    bool enabled = false;
+    juce::uint32 usefulLevels = (1u << numLevels) - 1;
+
+    Level level = full;
+    double averageLoad = 0.0, secondsSinceChange = 0.0, secondsWithHeadroom = 0.0;
+    double stepUpWait = stepUpSeconds;
+    bool steppedUp = false;
+};
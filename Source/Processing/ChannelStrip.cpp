@@ -0,0 +1,519 @@
+/*
+  ==============================================================================
+
+    ChannelStrip.cpp
+    Created: 16 Oct 2026 2:31:47pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "ChannelStrip.h"
+
+template <typename SampleType>
+ChannelStrip<SampleType>::ChannelStrip(){
+    inputGain .setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+    outputGain.setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+}
+
+//==============================================================================
+/** Sets the gain applied before the compressor in decibels */
+template <typename SampleType>
+void ChannelStrip<SampleType>::setInputGainDecibels(SampleType newGainDecibels){
+    inputGain.setTargetValue (juce::Decibels::decibelsToGain (newGainDecibels));
+}
+
+/** Sets the gain applied after the compressor in decibels */
+template <typename SampleType>
+void ChannelStrip<SampleType>::setOutputGainDecibels(SampleType newGainDecibels){
+    outputGain.setTargetValue (juce::Decibels::decibelsToGain (newGainDecibels));
+}
+
+/** Sets the length of the ramp used when either gain changes */
+template <typename SampleType>
+void ChannelStrip<SampleType>::setRampDurationSeconds(double newDurationSeconds){
+    if (! juce::approximatelyEqual (rampDurationSeconds, newDurationSeconds))
+    {
+        rampDurationSeconds = newDurationSeconds;
+        compressor.setRampDurationSeconds (rampDurationSeconds);
+        reset();
+    }
+}
+
+/** Sets the oversampling factor and filter type */
+template <typename SampleType>
+void ChannelStrip<SampleType>::setOversampling(int newFactorLog2, bool useLinearPhase){
+    jassert (newFactorLog2 >= 0 && newFactorLog2 <= maxOversamplingFactorLog2);
+    newFactorLog2 = juce::jlimit (0, oversamplingLimitLog2, newFactorLog2);
+
+    if (newFactorLog2 == oversamplingFactorLog2 && useLinearPhase == useLinearPhaseOversampling)
+        return;
+
+    const auto needsFade = getOversampler (newFactorLog2, useLinearPhase) != oversampler;
+
+    if (needsFade)
+        startOversamplingFade();
+
+    oversamplingFactorLog2     = newFactorLog2;
+    useLinearPhaseOversampling = useLinearPhase;
+
+    selectOversampler();
+
+    // The new path starts from silence, it only fades in once its filters
+    // and its lookahead are filled, like leaving a full bypass
+    if (needsFade)
+        fadePrimingSamples = getLatencySamples();
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::setLatencyFactor(int factorLog2){
+    latencyFactorLog2 = juce::jlimit (0, maxOversamplingFactorLog2, factorLog2);
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::setOversamplingLimit(int newLimitLog2){
+    oversamplingLimitLog2 = juce::jlimit (0, maxOversamplingFactorLog2, newLimitLog2);
+    oversamplingFactorLog2 = juce::jmin (oversamplingFactorLog2, oversamplingLimitLog2);
+}
+
+/** Sets the lookahead of the compressor in milliseconds */
+template <typename SampleType>
+void ChannelStrip<SampleType>::setLookahead(SampleType newLookahead){
+    // The dry delay is only as long as the longest lookahead
+    lookaheadTime = juce::jlimit (SampleType (0), SampleType (Compressor<SampleType>::maxLookaheadMs), newLookahead);
+    updateLookahead();
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::setMeteringEnabled(bool shouldMeter){
+    isMetering = shouldMeter;
+
+    // Only their gain reduction is read, the levels are the strip's own
+    compressor      .setMeteringEnabled (shouldMeter);
+    fadingCompressor.setMeteringEnabled (shouldMeter);
+}
+
+template <typename SampleType>
+int ChannelStrip<SampleType>::getLatencySamples() const{
+    return getOversamplingLatency() + (compressor.getLatencySamples() >> oversamplingFactorLog2);
+}
+
+//==============================================================================
+template <typename SampleType>
+void ChannelStrip<SampleType>::prepare(const juce::dsp::ProcessSpec& spec){
+    jassert (spec.sampleRate > 0);
+    jassert (spec.maximumBlockSize > 0);
+
+    sampleRate   = spec.sampleRate;
+    maxBlockSize = spec.maximumBlockSize;
+
+    // Everything is sized for the highest factor, so switching never allocates
+    preparedLimitLog2 = oversamplingLimitLog2;
+    const auto maxOversampledBlockSize = maxBlockSize << preparedLimitLog2;
+
+    inputGainRamp .assign (maxOversampledBlockSize, static_cast<SampleType> (1.0));
+    outputGainRamp.assign (maxOversampledBlockSize, static_cast<SampleType> (1.0));
+
+    oversampler = nullptr;
+    oversamplers.clear();
+
+    for (auto filterType : { Oversampler::filterHalfBandPolyphaseIIR, Oversampler::filterHalfBandFIREquiripple })
+    {
+        for (int factorLog2 = 1; factorLog2 <= preparedLimitLog2; ++factorLog2)
+        {
+            // Integer latency, so the host can compensate it exactly
+            auto newOversampler = std::make_unique<Oversampler> (spec.numChannels, (size_t) factorLog2, filterType, true, true);
+            newOversampler->initProcessing (maxBlockSize);
+            oversamplers.push_back (std::move (newOversampler));
+        }
+    }
+
+    const juce::dsp::ProcessSpec compressorSpec { sampleRate * (1 << preparedLimitLog2),
+                                                  static_cast<juce::uint32> (maxOversampledBlockSize),
+                                                  spec.numChannels };
+    compressor.prepare (compressorSpec);
+
+    // Only needed to fade between oversamplers
+    if (preparedLimitLog2 > 0)
+        fadingCompressor.prepare (compressorSpec);
+
+    // The dry delay has to cover the highest latency any setting can have
+    auto maxLatencySamples = juce::roundToInt (std::ceil (Compressor<SampleType>::maxLookaheadMs * 0.001 * sampleRate));
+    auto maxOversamplingLatency = 0;
+
+    for (auto& variant : oversamplers)
+        maxOversamplingLatency = juce::jmax (maxOversamplingLatency, juce::roundToInt (variant->getLatencyInSamples()));
+
+    maxLatencySamples += maxOversamplingLatency;
+
+    dryDelaySize = static_cast<size_t> (maxLatencySamples) + maxBlockSize;
+    dryDelay.assign (dryDelaySize * spec.numChannels, static_cast<SampleType> (0.0));
+    dryBuffer.setSize ((int) spec.numChannels, (int) maxBlockSize);
+    dryMixRamp.assign (maxBlockSize, static_cast<SampleType> (0.0));
+
+    fadingBuffer.setSize ((int) spec.numChannels, (int) maxBlockSize);
+    paddedBuffer.setSize ((int) spec.numChannels, (int) maxBlockSize);
+    oversamplingFadeRamp.assign (maxBlockSize, static_cast<SampleType> (0.0));
+    oversamplingFade.reset (sampleRate, oversamplingFadeSeconds);
+
+    selectOversampler();
+    reset();
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::reset(){
+    resetProcessing();
+
+    std::fill (dryDelay.begin(), dryDelay.end(), static_cast<SampleType> (0.0));
+    dryWritePosition = 0;
+
+    // Starts in the requested state, without a fade
+    dryMix.setCurrentAndTargetValue (static_cast<SampleType> (bypassed ? 1.0 : 0.0));
+    dryMix.reset (sampleRate, bypassFadeSeconds);
+    primingSamples = 0;
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::resetProcessing(){
+    inputGain .reset (getProcessingSampleRate(), rampDurationSeconds);
+    outputGain.reset (getProcessingSampleRate(), rampDurationSeconds);
+
+    if (oversampler != nullptr)
+        oversampler->reset();
+
+    compressor.reset();
+    oversamplingFade.setCurrentAndTargetValue (static_cast<SampleType> (0.0));
+    fadePrimingSamples = 0;
+}
+
+//==============================================================================
+/** Adds every channel of the block to a running peak and sum of squares */
+template <typename SampleType>
+static void accumulateLevels(const juce::dsp::AudioBlock<const SampleType>& block, SampleType& peak, SampleType& squares){
+    auto newPeak = peak, newSquares = squares;
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        const auto* samples = block.getChannelPointer (channel);
+
+        for (size_t i = 0; i < block.getNumSamples(); ++i)
+        {
+            const auto magnitude = std::abs (samples[i]);
+            newPeak     = newPeak < magnitude ? magnitude : newPeak;
+            newSquares += samples[i] * samples[i];
+        }
+    }
+
+    peak    = newPeak;
+    squares = newSquares;
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::processBlock(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                            const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                                            const juce::dsp::AudioBlock<const SampleType>& keyBlock){
+    // Before processing, the output may be the input
+    if (isMetering)
+        accumulateLevels (inputBlock, levels.inputPeak, levels.inputSquares);
+
+    // Always written, so the dry signal is ready whenever a fade starts
+    pushDry (inputBlock);
+
+    if (isFullyBypassed())
+    {
+        const auto numSamples = (int) outputBlock.getNumSamples();
+        inputGain .skip (numSamples << oversamplingFactorLog2);
+        outputGain.skip (numSamples << oversamplingFactorLog2);
+
+        readDry (outputBlock, getLatencySamples());
+    }
+    else if (! dryMix.isSmoothing())
+    {
+        processWet (inputBlock, outputBlock, keyBlock);
+    }
+    else
+    {
+        // Fading, the output may be the input so the dry signal is read first
+        auto dryBlock = juce::dsp::AudioBlock<SampleType> (dryBuffer).getSubsetChannelBlock (0, outputBlock.getNumChannels())
+                                                                      .getSubBlock (0, outputBlock.getNumSamples());
+        readDry (dryBlock, getLatencySamples());
+        processWet (inputBlock, outputBlock, keyBlock);
+        crossfade (outputBlock, dryBlock);
+    }
+
+    if (isMetering)
+    {
+        accumulateLevels (juce::dsp::AudioBlock<const SampleType> (outputBlock), levels.outputPeak, levels.outputSquares);
+        levels.numValues += outputBlock.getNumSamples() * outputBlock.getNumChannels();
+        collectGainReduction();
+    }
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::collectGainReduction(){
+    // The fading compressor only has levels while a fade runs
+    levels.minGain = juce::jmin (levels.minGain, compressor.getLevels().minGain, fadingCompressor.getLevels().minGain);
+
+    compressor      .resetLevels();
+    fadingCompressor.resetLevels();
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::processWet(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                          const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                                          const juce::dsp::AudioBlock<const SampleType>& keyBlock){
+    const WetPath path { oversampler, oversamplingFactorLog2, compressor, inputGain, outputGain };
+
+    if (! oversamplingFade.isSmoothing())
+    {
+        processPath (path, inputBlock, outputBlock, keyBlock);
+        return;
+    }
+
+    // The old path first, the output may be the input
+    const auto numSamples = outputBlock.getNumSamples();
+    auto fadingBlock = juce::dsp::AudioBlock<SampleType> (fadingBuffer).getSubsetChannelBlock (0, outputBlock.getNumChannels())
+                                                                        .getSubBlock (0, numSamples);
+
+    processPath ({ fadingOversampler, fadingFactorLog2, fadingCompressor, fadingInputGain, fadingOutputGain },
+                 inputBlock, fadingBlock, keyBlock);
+    processPath (path, inputBlock, outputBlock, keyBlock);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        if (fadePrimingSamples > 0)
+        {
+            --fadePrimingSamples;
+            oversamplingFadeRamp[i] = static_cast<SampleType> (1.0);
+        }
+        else
+        {
+            oversamplingFadeRamp[i] = oversamplingFade.getNextValue();
+        }
+    }
+
+    // Linear like the bypass fade, both paths carry the same signal
+    for (size_t channel = 0; channel < outputBlock.getNumChannels(); ++channel)
+    {
+        auto* outputSamples      = outputBlock.getChannelPointer (channel);
+        const auto* fadingSamples = fadingBlock.getChannelPointer (channel);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            outputSamples[i] = outputSamples[i] * (static_cast<SampleType> (1.0) - oversamplingFadeRamp[i])
+                             + fadingSamples[i] * oversamplingFadeRamp[i];
+    }
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::processPath(const WetPath& path,
+                                           const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                           const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                                           const juce::dsp::AudioBlock<const SampleType>& keyBlock){
+    const auto numSamples = outputBlock.getNumSamples();
+
+    // A path with less latency than the strip's reads its input that much
+    // later from the dry delay, which already holds this block. While a fade
+    // runs that covers whichever of the two paths is earlier.
+    const auto padding = getOversamplingLatency() - getOversamplerLatency (path.oversampler);
+    auto paddedBlock = juce::dsp::AudioBlock<SampleType> (paddedBuffer).getSubsetChannelBlock (0, outputBlock.getNumChannels())
+                                                                        .getSubBlock (0, numSamples);
+
+    if (padding > 0)
+        readDry (paddedBlock, padding);
+
+    const auto pathInputBlock = padding > 0 ? juce::dsp::AudioBlock<const SampleType> (paddedBlock) : inputBlock;
+
+    if (path.oversampler == nullptr)
+    {
+        const auto* inputGains  = fillGainRamp (path.inputGain,  inputGainRamp,  numSamples);
+        const auto* outputGains = fillGainRamp (path.outputGain, outputGainRamp, numSamples);
+
+        path.compressor.processBlock (pathInputBlock, outputBlock, inputGains, outputGains, keyBlock);
+        return;
+    }
+
+    // The gains ramp at the oversampled rate, so they stay fused into the kernel
+    auto oversampledBlock = [&] {
+        COMPRESSOR_TRACE_STAGE ("oversampling up");
+        return path.oversampler->processSamplesUp (pathInputBlock);
+    }();
+
+    const auto numOversampledSamples = oversampledBlock.getNumSamples();
+
+    const auto* inputGains  = fillGainRamp (path.inputGain,  inputGainRamp,  numOversampledSamples);
+    const auto* outputGains = fillGainRamp (path.outputGain, outputGainRamp, numOversampledSamples);
+
+    path.compressor.processBlock (oversampledBlock, oversampledBlock, inputGains, outputGains, keyBlock, path.factorLog2);
+
+    COMPRESSOR_TRACE_STAGE ("oversampling down");
+    path.oversampler->processSamplesDown (outputBlock);
+}
+
+template <typename SampleType>
+const SampleType* ChannelStrip<SampleType>::fillGainRamp(ParameterRamp<SampleType>& gain,
+                                                         std::vector<SampleType>& buffer,
+                                                         size_t numSamples){
+    jassert (numSamples <= buffer.size());
+
+    if (! gain.isSmoothing() && gain.getTargetValue() == static_cast<SampleType> (1.0))
+        return nullptr;
+
+    gain.fill (buffer.data(), numSamples);
+    return buffer.data();
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::updateBypass(bool shouldBeBypassed){
+    const auto target = static_cast<SampleType> (shouldBeBypassed ? 1.0 : 0.0);
+
+    if (dryMix.getTargetValue() == target)
+        return;
+
+    // Nothing ran while fully bypassed, so the processing restarts from
+    // silence and only fades in once it has been fed for its latency
+    if (isFullyBypassed())
+    {
+        resetProcessing();
+        primingSamples = getLatencySamples();
+    }
+
+    dryMix.setTargetValue (target);
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::pushDry(const juce::dsp::AudioBlock<const SampleType>& inputBlock){
+    const auto numSamples = inputBlock.getNumSamples();
+    const auto firstPart  = juce::jmin (numSamples, dryDelaySize - dryWritePosition);
+
+    for (size_t channel = 0; channel < inputBlock.getNumChannels(); ++channel)
+    {
+        const auto* inputSamples = inputBlock.getChannelPointer (channel);
+        auto* ring = dryDelay.data() + channel * dryDelaySize;
+
+        std::copy (inputSamples, inputSamples + firstPart, ring + dryWritePosition);
+        std::copy (inputSamples + firstPart, inputSamples + numSamples, ring);
+    }
+
+    dryWritePosition = (dryWritePosition + numSamples) % dryDelaySize;
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::readDry(const juce::dsp::AudioBlock<SampleType>& outputBlock, int delay) const{
+    const auto numSamples = outputBlock.getNumSamples();
+    const auto latency    = static_cast<size_t> (delay);
+
+    jassert (numSamples + latency <= dryDelaySize);
+
+    // The block just pushed ends at the write position
+    const auto readPosition = (dryWritePosition + 2 * dryDelaySize - numSamples - latency) % dryDelaySize;
+    const auto firstPart    = juce::jmin (numSamples, dryDelaySize - readPosition);
+
+    for (size_t channel = 0; channel < outputBlock.getNumChannels(); ++channel)
+    {
+        const auto* ring = dryDelay.data() + channel * dryDelaySize;
+        auto* outputSamples = outputBlock.getChannelPointer (channel);
+
+        std::copy (ring + readPosition, ring + readPosition + firstPart, outputSamples);
+        std::copy (ring, ring + (numSamples - firstPart), outputSamples + firstPart);
+    }
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::crossfade(const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                                         const juce::dsp::AudioBlock<SampleType>& dryBlock){
+    const auto numSamples = outputBlock.getNumSamples();
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        if (primingSamples > 0)
+        {
+            --primingSamples;
+            dryMixRamp[i] = static_cast<SampleType> (1.0);
+        }
+        else
+        {
+            dryMixRamp[i] = dryMix.getNextValue();
+        }
+    }
+
+    // Linear, the two signals are correlated so their sum doesn't dip
+    for (size_t channel = 0; channel < outputBlock.getNumChannels(); ++channel)
+    {
+        auto* outputSamples   = outputBlock.getChannelPointer (channel);
+        const auto* drySamples = dryBlock.getChannelPointer (channel);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            outputSamples[i] = outputSamples[i] * (static_cast<SampleType> (1.0) - dryMixRamp[i]) + drySamples[i] * dryMixRamp[i];
+    }
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::selectOversampler(){
+    // Only a prepare() can raise the limit, until then the factor stays within the old one
+    oversamplingFactorLog2 = juce::jmin (oversamplingFactorLog2, preparedLimitLog2);
+
+    oversampler = getOversampler (oversamplingFactorLog2, useLinearPhaseOversampling);
+
+    if (oversampler != nullptr)
+        oversampler->reset();
+
+    compressor.setSampleRate (getProcessingSampleRate());
+    updateLookahead();
+
+    // Restarts the gain ramps at the new rate, on their target values
+    inputGain .reset (getProcessingSampleRate(), rampDurationSeconds);
+    outputGain.reset (getProcessingSampleRate(), rampDurationSeconds);
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::startOversamplingFade(){
+    // Nothing to fade from before prepare(), or while only the dry signal is heard
+    if (maxBlockSize == 0 || isFullyBypassed())
+        return;
+
+    fadingCompressor.copyStateFrom (compressor);
+    fadingInputGain   = inputGain;
+    fadingOutputGain  = outputGain;
+    fadingOversampler = oversampler;
+    fadingFactorLog2  = oversamplingFactorLog2;
+
+    oversamplingFade.setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+    oversamplingFade.setTargetValue (static_cast<SampleType> (0.0));
+}
+
+template <typename SampleType>
+typename ChannelStrip<SampleType>::Oversampler* ChannelStrip<SampleType>::getOversampler(int factorLog2, bool useLinearPhase) const{
+    if (factorLog2 <= 0 || factorLog2 > preparedLimitLog2)
+        return nullptr;
+
+    const auto index = (useLinearPhase ? preparedLimitLog2 : 0) + factorLog2 - 1;
+    return index < (int) oversamplers.size() ? oversamplers[(size_t) index].get() : nullptr;
+}
+
+template <typename SampleType>
+int ChannelStrip<SampleType>::getOversamplingLatency() const{
+    const auto latency = juce::jmax (getOversamplerLatency (oversampler),
+                                     getOversamplerLatency (getOversampler (latencyFactorLog2, useLinearPhaseOversampling)));
+
+    // Both paths of a fade line up on the later one, or they would comb
+    if (oversamplingFade.isSmoothing())
+        return juce::jmax (latency, getOversamplerLatency (fadingOversampler));
+
+    return latency;
+}
+
+template <typename SampleType>
+int ChannelStrip<SampleType>::getOversamplerLatency(Oversampler* pathOversampler){
+    return pathOversampler != nullptr ? juce::roundToInt (pathOversampler->getLatencyInSamples()) : 0;
+}
+
+template <typename SampleType>
+void ChannelStrip<SampleType>::updateLookahead(){
+    // Whole samples at the base rate are whole samples at any oversampled rate
+    const auto lookaheadSamples = juce::roundToInt (static_cast<double> (lookaheadTime) * 0.001 * sampleRate);
+    compressor.setLookahead (static_cast<SampleType> (lookaheadSamples * 1000.0 / sampleRate));
+}
+
+//==============================================================================
+template class ChannelStrip<float>;
+template class ChannelStrip<double>;
@@ -0,0 +1,273 @@
+/*
+  ==============================================================================
+
+    ChannelStrip.h
+    Created: 16 Oct 2026 2:31:47pm
+    Author:  Chris
+ 
+    Input gain -> compressor -> output gain, fused into a single pass over the
+    buffer. The gains ramp like juce::dsp::Gain (linearly, one ramp per gain
+    shared by every channel), but instead of running as separate passes, the
+    ramps are written to small per sample buffers and applied by the
+    compressor's block kernel while it already has the samples in hand. The
+    compressor ramps its threshold over the same time.
+
+    Bypass fades to the input, delayed by the latency of the strip so that
+    bypassing never moves the audio in time. Once fully bypassed, only that
+    delay runs. Changing the oversampling fades from the old oversampler to
+    the new one the same way, both run until the fade is over.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Compressor.h"
+
+template <typename SampleType>
+class ChannelStrip {
+public:
+    //==============================================================================
+    ChannelStrip();
+    
+    //==============================================================================
+    /** Sets the gain applied before the compressor in decibels */
+    void setInputGainDecibels (SampleType newGainDecibels);
+    
+    /** Sets the gain applied after the compressor in decibels */
+    void setOutputGainDecibels (SampleType newGainDecibels);
+    
+    /** Sets the length of the ramp used when either gain or the threshold
+        changes, like juce::dsp::Gain::setRampDurationSeconds */
+    void setRampDurationSeconds (double newDurationSeconds);
+    
+    /** Runs the compressor at 2^newFactorLog2 times the sample rate, up to
+        maxOversamplingFactorLog2, so only this stage pays for the oversampling.
+        The filters are polyphase IIR, or linear phase FIR when useLinearPhase
+        is true. Every variant is allocated in prepare(), so switching doesn't
+        allocate. The output crossfades from the old setting to the new one
+        over oversamplingFadeSeconds, once the new setting has been fed for
+        getLatencySamples(). Switching changes getLatencySamples(), unless
+        setLatencyFactor() pads it. While the fade runs it holds the larger
+        latency of the two settings, so lowering it takes effect when the
+        fade ends. */
+    void setOversampling (int newFactorLog2, bool useLinearPhase);
+    
+    static constexpr int maxOversamplingFactorLog2 = 3;
+    static constexpr double oversamplingFadeSeconds = 0.02;
+    
+    /** Pads the latency to that of 2^factorLog2 oversampling with the current
+        filters whenever the strip runs at a lower factor, so lowering the
+        oversampling, e.g. to save time, doesn't move the audio. The input is
+        delayed by the difference before it reaches the compressor. The key
+        isn't, so while padded the detector hears it that much early. 0, the
+        default, pads nothing. */
+    void setLatencyFactor (int factorLog2);
+    
+    /** Limits the factors prepare() allocates for, from 0 (no oversampling)
+        to maxOversamplingFactorLog2 (the default), so strips that never
+        oversample don't carry the filters and buffers for it.
+        setOversampling() clamps to it. Takes effect at the next prepare(). */
+    void setOversamplingLimit (int newLimitLog2);
+    
+    /** Sets the lookahead of the compressor in milliseconds, up to
+        Compressor::maxLookaheadMs. It is rounded to whole samples at the base
+        rate, so the latency stays an integer at any oversampling factor. */
+    void setLookahead (SampleType newLookahead);
+    
+    /** The latency of the oversampling filters, or of the ones
+        setLatencyFactor() pads to or an oversampling fade runs from when
+        it's higher, plus the lookahead, in samples at the base rate */
+    int getLatencySamples () const;
+    
+    /** Crossfades to the dry signal, or back, over bypassFadeSeconds. Leaving
+        a full bypass restarts the processing from silence, and holds the dry
+        signal for getLatencySamples() before fading, until the processed
+        signal is valid again. A bypassed ProcessContext does the same. */
+    void setBypassed (bool shouldBeBypassed) { bypassed = shouldBeBypassed; }
+    
+    static constexpr double bypassFadeSeconds = 0.02;
+    
+    Compressor<SampleType>& getCompressor () { return compressor; }
+    
+    using Levels = typename Compressor<SampleType>::Levels;
+    
+    /** While enabled, process() records the Levels of the strip's input and
+        output at the base rate, whatever the oversampling, and the gain
+        reduction of its compressors, the fading one included. Off by default,
+        it costs a pass over the input and the output. */
+    void setMeteringEnabled (bool shouldMeter);
+    
+    const Levels& getLevels () const { return levels; }
+    
+    void resetLevels () { levels = {}; }
+    
+    //==============================================================================
+    /** Initializes the channel strip */
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    
+    void reset ();
+    
+    //==============================================================================
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) {
+        process (context, {});
+    }
+    
+    /** Like process(), with the compressor's detector fed from keyBlock, e.g. a
+        sidechain bus, read in place. An empty keyBlock means no key, see
+        Compressor::processBlock() for the channels it may have. */
+    template <typename ProcessContext>
+    void process (const ProcessContext& context, const juce::dsp::AudioBlock<const SampleType>& keyBlock) {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock      = context.getOutputBlock();
+        const auto numSamples  = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples()  == numSamples);
+        jassert (keyBlock.getNumChannels() == 0 || keyBlock.getNumSamples() == numSamples);
+
+        // Not prepared, there are no buffers to walk the block with
+        jassert (maxBlockSize > 0);
+
+        if (maxBlockSize == 0)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        updateBypass (bypassed || context.isBypassed);
+
+        // Hosts may send more samples than announced in prepare, so walk the
+        // block in pieces the ramp buffers can hold
+        for (size_t startSample = 0; startSample < numSamples; startSample += maxBlockSize)
+        {
+            const auto blockSize = juce::jmin (maxBlockSize, numSamples - startSample);
+
+            processBlock (inputBlock .getSubBlock (startSample, blockSize),
+                          outputBlock.getSubBlock (startSample, blockSize),
+                          keyBlock.getNumChannels() > 0 ? keyBlock.getSubBlock (startSample, blockSize) : keyBlock);
+        }
+    }
+    
+private:
+    //==============================================================================
+    void processBlock (const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                       const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                       const juce::dsp::AudioBlock<const SampleType>& keyBlock);
+    
+    /** input gain -> compressor -> output gain, oversampled if enabled, and
+        faded from the old oversampling while it changes */
+    void processWet (const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                     const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                     const juce::dsp::AudioBlock<const SampleType>& keyBlock);
+    
+    /** The oversampler, the compressor and the gains one setting of the
+        oversampling runs through */
+    struct WetPath {
+        juce::dsp::Oversampling<SampleType>* oversampler;
+        int factorLog2;
+        Compressor<SampleType>& compressor;
+        ParameterRamp<SampleType>& inputGain;
+        ParameterRamp<SampleType>& outputGain;
+    };
+    
+    /** Runs the input through one path, delayed first by what its latency
+        lacks. The key stays at the base rate, the compressor holds each of
+        its samples. */
+    void processPath (const WetPath& path,
+                      const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                      const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                      const juce::dsp::AudioBlock<const SampleType>& keyBlock);
+    
+    /** Takes the gain reduction of both compressors into levels */
+    void collectGainReduction ();
+    
+    /** Starts a fade when the bypass state changes */
+    void updateBypass (bool shouldBeBypassed);
+    
+    bool isFullyBypassed () const { return ! dryMix.isSmoothing() && dryMix.getCurrentValue() == static_cast<SampleType> (1.0); }
+    
+    /** Writes the input to the dry delay, and reads it back delay samples late */
+    void pushDry (const juce::dsp::AudioBlock<const SampleType>& inputBlock);
+    void readDry (const juce::dsp::AudioBlock<SampleType>& outputBlock, int delay) const;
+    
+    /** Mixes the dry block into the processed one, following dryMix */
+    void crossfade (const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                    const juce::dsp::AudioBlock<SampleType>& dryBlock);
+    
+    /** Hands the current path over to the fading one, see setOversampling() */
+    void startOversamplingFade ();
+    
+    /** Clears the state of everything but the dry delay */
+    void resetProcessing ();
+    
+    /** Writes the next numSamples values of a gain ramp to the buffer. Returns
+        nullptr instead when the gain is steady at unity, so the kernel can skip it. */
+    static const SampleType* fillGainRamp (ParameterRamp<SampleType>& gain,
+                                           std::vector<SampleType>& buffer,
+                                           size_t numSamples);
+    
+    /** Switches to the oversampler for the current settings and moves the
+        compressor and the gain ramps to its rate */
+    void selectOversampler ();
+    
+    /** The oversampler of a factor and filter type, nullptr for no oversampling */
+    juce::dsp::Oversampling<SampleType>* getOversampler (int factorLog2, bool useLinearPhase) const;
+    
+    /** The latency of the oversampling, padded, in samples at the base rate.
+        Includes the fading path while there is one. */
+    int getOversamplingLatency () const;
+    
+    static int getOversamplerLatency (juce::dsp::Oversampling<SampleType>* pathOversampler);
+    
+    void updateLookahead ();
+    
+    double getProcessingSampleRate () const { return sampleRate * (1 << oversamplingFactorLog2); }
+    
+    //==============================================================================
+    Compressor<SampleType> compressor;
+    
+    ParameterRamp<SampleType> inputGain, outputGain;
+    std::vector<SampleType> inputGainRamp, outputGainRamp;
+    
+    // One oversampler per factor and filter type, created in prepare()
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+    std::vector<std::unique_ptr<Oversampler>> oversamplers;
+    Oversampler* oversampler = nullptr;
+    
+    int oversamplingFactorLog2 = 0, oversamplingLimitLog2 = maxOversamplingFactorLog2;
+    int preparedLimitLog2 = maxOversamplingFactorLog2, latencyFactorLog2 = 0;
+    bool useLinearPhaseOversampling = false;
+    
+    // The path of the previous oversampling while it fades out, from 1 to 0.
+    // Its compressor is prepared like the other, so taking over its state
+    // doesn't allocate.
+    Compressor<SampleType> fadingCompressor;
+    ParameterRamp<SampleType> fadingInputGain, fadingOutputGain;
+    Oversampler* fadingOversampler = nullptr;
+    int fadingFactorLog2 = 0, fadePrimingSamples = 0;
+    juce::SmoothedValue<SampleType> oversamplingFade;
+    std::vector<SampleType> oversamplingFadeRamp;
+    juce::AudioBuffer<SampleType> fadingBuffer, paddedBuffer;
+    
+    SampleType lookaheadTime = 0;
+    
+    // Bypass, 0 is fully processed and 1 fully dry. The dry delay holds one
+    // ring of dryDelaySize samples per channel.
+    bool bypassed = false;
+    juce::SmoothedValue<SampleType> dryMix;
+    std::vector<SampleType> dryMixRamp;
+    int primingSamples = 0;
+    
+    std::vector<SampleType> dryDelay;
+    size_t dryDelaySize = 0, dryWritePosition = 0;
+    juce::AudioBuffer<SampleType> dryBuffer;
+    
+    bool isMetering = false;
+    Levels levels;
+    
+    double sampleRate = 44100.0, rampDurationSeconds = 0.0;
+    size_t maxBlockSize = 0;
+};
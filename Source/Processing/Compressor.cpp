@@ -10,6 +10,511 @@
 
 #include "Compressor.h"
 
+//==============================================================================
+template <typename SampleType>
+static inline SampleType exactGain(SampleType env, const VCACoefficients<SampleType>& c){
+    return (env < c.threshold) ? static_cast<SampleType> (1.0)
+                               : std::pow (env * c.thresholdInverse, c.exponent);
+}
+
+/** Same curve as exactGain, evaluated as exp2 ((log2 (env) - log2 (threshold)) * exponent).
+    Below the threshold the overshoot clamps to 0 and the gain is exactly 1, so
+    loops calling this have no branches. */
+template <typename SampleType>
+static inline SampleType approximateGain(SampleType env, const VCACoefficients<SampleType>& c){
+    const auto overshoot = juce::jmax (FastMath::log2 (env) - c.thresholdLog2, static_cast<SampleType> (0.0));
+    return FastMath::exp2 (overshoot * c.exponent);
+}
+
+/** The soft knee curve, in octaves of the envelope. With t the overshoot plus
+    half the knee, clamped to the knee, the gain is exp2 (k * exponent) where
+        k = t * t / (2 * kneeWidth) + max (overshoot - kneeWidth / 2, 0)
+    which is 0 below the knee, quadratic across it, and the overshoot above
+    it. Below the knee k is exactly 0 and the gain exactly 1, and the loops
+    calling this have no branches. The exact engine gets the overshoot like
+    exactGain does, the fast one like approximateGain. */
+template <bool useFastMath, typename SampleType>
+static inline SampleType softKneeGain(SampleType env, const VCACoefficients<SampleType>& c){
+    SampleType overshoot;
+
+    if constexpr (useFastMath)
+        overshoot = FastMath::log2 (env) - c.thresholdLog2;
+    else
+        overshoot = std::log2 (env * c.thresholdInverse);
+
+    const auto halfWidth = c.kneeWidth * static_cast<SampleType> (0.5);
+
+    auto inKnee = overshoot + halfWidth;
+    inKnee = inKnee < static_cast<SampleType> (0.0) ? static_cast<SampleType> (0.0) : inKnee;
+    inKnee = inKnee > c.kneeWidth ? c.kneeWidth : inKnee;
+
+    auto aboveKnee = overshoot - halfWidth;
+    aboveKnee = aboveKnee < static_cast<SampleType> (0.0) ? static_cast<SampleType> (0.0) : aboveKnee;
+
+    const auto gainLog2 = (inKnee * inKnee * c.kneeScale + aboveKnee) * c.exponent;
+
+    if constexpr (useFastMath)
+        return FastMath::exp2 (gainLog2);
+    else
+        return std::exp2 (gainLog2);
+}
+
+/** exactGain for one of the fixed ratio choices. 4:1 and 8:1 reduce to chains of
+    square roots (x^-0.75 and x^-0.875), which are cheap and vectorize. 12:1 and
+    20:1 would need a cube or fifth root, so they keep std::pow, but with the
+    exponent folded to a constant. Results are within a few ulps of exactGain.
+
+    Below the threshold the curve is above 1, so clamping it to 1 replaces the
+    threshold comparison and leaves the loop without branches. */
+template <int Ratio, typename SampleType>
+static inline SampleType fixedRatioGain(SampleType env, const VCACoefficients<SampleType>& c){
+    const auto x = env * c.thresholdInverse;
+    SampleType gain;
+
+    if constexpr (Ratio == 4)
+    {
+        const auto root2 = std::sqrt (x);
+        gain = static_cast<SampleType> (1.0) / (root2 * std::sqrt (root2));
+    }
+    else if constexpr (Ratio == 8)
+    {
+        const auto root2 = std::sqrt (x);
+        const auto root4 = std::sqrt (root2);
+        gain = static_cast<SampleType> (1.0) / (root2 * root4 * std::sqrt (root4));
+    }
+    else
+    {
+        constexpr auto exponent = static_cast<SampleType> (1.0) / static_cast<SampleType> (Ratio) - static_cast<SampleType> (1.0);
+        gain = std::pow (x, exponent);
+    }
+
+    return (gain < static_cast<SampleType> (1.0)) ? gain : static_cast<SampleType> (1.0);
+}
+
+/** Replaces every envelope value in the buffer with its gain. The coefficients
+    are taken by value so the loop can keep them in registers; reading members
+    here would alias the envelope buffer and stop the compiler from vectorizing. */
+template <typename SampleType, SampleType (*gainFunction) (SampleType, const VCACoefficients<SampleType>&)>
+static void applyGain(SampleType* envelope, size_t numValues, VCACoefficients<SampleType> c){
+    for (size_t i = 0; i < numValues; ++i)
+        envelope[i] = gainFunction (envelope[i], c);
+}
+
+template <typename SampleType>
+using GainKernel = void (*) (SampleType*, size_t, VCACoefficients<SampleType>);
+
+/** Picks the VCA kernel for the current engine, ratio and knee, once per block */
+template <typename SampleType>
+static GainKernel<SampleType> getGainKernel(GainEngine engine, SampleType ratio, SampleType kneeWidth){
+    if (kneeWidth > static_cast<SampleType> (0.0))
+        return engine == GainEngine::fastApproximation ? applyGain<SampleType, softKneeGain<true, SampleType>>
+                                                       : applyGain<SampleType, softKneeGain<false, SampleType>>;
+
+    if (engine == GainEngine::fastApproximation)
+        return applyGain<SampleType, approximateGain<SampleType>>;
+
+    if (ratio == static_cast<SampleType> (4))
+        return applyGain<SampleType, fixedRatioGain<4, SampleType>>;
+
+    if (ratio == static_cast<SampleType> (8))
+        return applyGain<SampleType, fixedRatioGain<8, SampleType>>;
+
+    if (ratio == static_cast<SampleType> (12))
+        return applyGain<SampleType, fixedRatioGain<12, SampleType>>;
+
+    if (ratio == static_cast<SampleType> (20))
+        return applyGain<SampleType, fixedRatioGain<20, SampleType>>;
+
+    return applyGain<SampleType, exactGain<SampleType>>;
+}
+
+/** Control rate VCA. Evaluates the kernel on the last frame of every segment of
+    `interval` frames and ramps linearly to it from the gain at the end of the
+    previous segment, so the gain is exact at every segment end. */
+template <typename SampleType>
+static void applyControlRateGain(SampleType* envelope, SampleType* previousGains, size_t numFrames, size_t interval,
+                                 GainKernel<SampleType> applyGainKernel, const VCACoefficients<SampleType>& c){
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    const auto numLanes = SIMDType::size();
+
+    auto previous = SIMDType::fromRawArray (previousGains);
+
+    for (size_t segmentStart = 0; segmentStart < numFrames; segmentStart += interval)
+    {
+        const auto segmentLength = juce::jmin (interval, numFrames - segmentStart);
+        auto* segment   = envelope + segmentStart * numLanes;
+        auto* lastFrame = segment + (segmentLength - 1) * numLanes;
+
+        applyGainKernel (lastFrame, numLanes, c);
+
+        const auto target = SIMDType::fromRawArray (lastFrame);
+        const auto step   = (target - previous) * (static_cast<SampleType> (1.0) / static_cast<SampleType> (segmentLength));
+
+        for (size_t i = 0; i + 1 < segmentLength; ++i)
+            (previous + step * static_cast<SampleType> (i + 1)).copyToRawArray (segment + i * numLanes);
+
+        previous = target;
+    }
+
+    previous.copyToRawArray (previousGains);
+}
+
+/** Interleaves the channels firstChannel to firstChannel + numActiveLanes of the
+    chunk into frames of numLanes values, one channel per lane, applying the
+    input gains if there are any. Lanes without a channel are fed silence so
+    their envelope stays at zero. */
+template <typename SampleType>
+static void interleaveChunk(SampleType* frames, const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                            size_t firstChannel, size_t numActiveLanes, size_t numLanes,
+                            size_t startSample, size_t chunkSize, const SampleType* inputGains){
+    if (numActiveLanes < numLanes)
+        std::fill (frames, frames + chunkSize * numLanes, static_cast<SampleType> (0.0));
+
+    for (size_t lane = 0; lane < numActiveLanes; ++lane)
+    {
+        const auto* inputSamples = inputBlock.getChannelPointer (firstChannel + lane) + startSample;
+
+        if (inputGains != nullptr)
+        {
+            for (size_t i = 0; i < chunkSize; ++i)
+                frames[i * numLanes + lane] = inputSamples[i] * inputGains[startSample + i];
+        }
+        else
+        {
+            for (size_t i = 0; i < chunkSize; ++i)
+                frames[i * numLanes + lane] = inputSamples[i];
+        }
+    }
+}
+
+/** interleaveChunk for the key. A key with one channel feeds every lane, and
+    each key sample is held for 2^keyRateShift frames. */
+template <typename SampleType>
+static void interleaveKeyChunk(SampleType* frames, const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                               size_t firstChannel, size_t numActiveLanes, size_t numLanes,
+                               size_t startSample, size_t chunkSize, int keyRateShift){
+    if (numActiveLanes < numLanes)
+        std::fill (frames, frames + chunkSize * numLanes, static_cast<SampleType> (0.0));
+
+    const auto isMonoKey = keyBlock.getNumChannels() == 1;
+
+    for (size_t lane = 0; lane < numActiveLanes; ++lane)
+    {
+        const auto* keySamples = keyBlock.getChannelPointer (isMonoKey ? 0 : firstChannel + lane);
+
+        if (keyRateShift == 0)
+        {
+            for (size_t i = 0; i < chunkSize; ++i)
+                frames[i * numLanes + lane] = keySamples[startSample + i];
+        }
+        else
+        {
+            for (size_t i = 0; i < chunkSize; ++i)
+                frames[i * numLanes + lane] = keySamples[(startSample + i) >> keyRateShift];
+        }
+    }
+}
+
+/** Writes the same chunk of samples into every active lane of numFrames
+    interleaved frames. The other lanes are silent. */
+template <typename SampleType>
+static void broadcastChunk(SampleType* frames, const SampleType* samples, size_t numActiveLanes, size_t numLanes,
+                           size_t numFrames){
+    if (numActiveLanes < numLanes)
+        std::fill (frames, frames + numFrames * numLanes, static_cast<SampleType> (0.0));
+
+    for (size_t i = 0; i < numFrames; ++i)
+        for (size_t lane = 0; lane < numActiveLanes; ++lane)
+            frames[i * numLanes + lane] = samples[i];
+}
+
+/** Runs a biquad over numFrames interleaved frames, one channel per lane, in
+    the transposed direct form II. state1 and state2 hold the two state values
+    of each lane. The source may be the destination.
+
+    The filter runs in double whatever the sample type. Near DC the direct
+    form needs every bit of its coefficients: in float a 20 Hz high-pass is
+    off by about a third of a dB at 384 kHz, and the compiler fusing a
+    multiply and an add moves that by a tenth. Double frames go a register
+    at a time, float ones lane by lane. */
+template <typename SampleType>
+static void filterFrames(const SampleType* source, SampleType* destination, size_t numFrames,
+                         double* state1, double* state2, const BiquadCoefficients<double>& c){
+    constexpr auto numLanes = juce::dsp::SIMDRegister<SampleType>::size();
+
+    if constexpr (std::is_same_v<SampleType, double>)
+    {
+        using SIMDType = juce::dsp::SIMDRegister<double>;
+
+        const auto b0 = SIMDType::expand (c.b0), b1 = SIMDType::expand (c.b1), b2 = SIMDType::expand (c.b2);
+        const auto a1 = SIMDType::expand (c.a1), a2 = SIMDType::expand (c.a2);
+
+        // The state isn't in the aligned storage, so it's moved lane by lane
+        auto z1 = SIMDType::expand (0.0), z2 = SIMDType::expand (0.0);
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            z1.set (lane, state1[lane]);
+            z2.set (lane, state2[lane]);
+        }
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto x = SIMDType::fromRawArray (source + i * numLanes);
+            const auto y = b0 * x + z1;
+
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+
+            y.copyToRawArray (destination + i * numLanes);
+        }
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            state1[lane] = z1.get (lane);
+            state2[lane] = z2.get (lane);
+        }
+    }
+    else
+    {
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            auto z1 = state1[lane], z2 = state2[lane];
+
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                const auto x = static_cast<double> (source[i * numLanes + lane]);
+                const auto y = c.b0 * x + z1;
+
+                z1 = c.b1 * x - c.a1 * y + z2;
+                z2 = c.b2 * x - c.a2 * y;
+
+                destination[i * numLanes + lane] = static_cast<SampleType> (y);
+            }
+
+            state1[lane] = z1;
+            state2[lane] = z2;
+        }
+    }
+}
+
+/** The lookahead ring of a lane group holds ringSize frames, followed by a copy
+    of its first mirrorSize frames. With the copy, any run of up to mirrorSize
+    frames starting inside the ring can be written or read contiguously. Call
+    this after writing the frames [position, position + numFrames) to keep the
+    two copies in sync. */
+template <typename SampleType>
+static void mirrorRingFrames(SampleType* ring, size_t ringSize, size_t mirrorSize,
+                             size_t position, size_t numFrames, size_t numLanes){
+    const auto end = position + numFrames;
+
+    if (end > ringSize)
+        std::copy (ring + ringSize * numLanes, ring + end * numLanes, ring);
+
+    if (position < mirrorSize)
+        std::copy (ring + position * numLanes, ring + juce::jmin (end, mirrorSize) * numLanes,
+                   ring + (ringSize + position) * numLanes);
+}
+
+/** Runs the peak rectifier ballistics over numFrames interleaved frames, one
+    channel per lane, with the same arithmetic as processSample. Writes every
+    envelope value to envelopeOut, unless it is nullptr, and returns the last. */
+template <typename SampleType>
+static juce::dsp::SIMDRegister<SampleType> followEnvelope(const SampleType* frames, size_t numFrames,
+                                                          juce::dsp::SIMDRegister<SampleType> env,
+                                                          juce::dsp::SIMDRegister<SampleType> attackCoefficient,
+                                                          juce::dsp::SIMDRegister<SampleType> releaseCoefficient,
+                                                          SampleType* envelopeOut){
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    const auto numLanes = SIMDType::size();
+
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        const auto input = SIMDType::abs (SIMDType::fromRawArray (frames + i * numLanes));
+        const auto cte   = (attackCoefficient  & SIMDType::greaterThan     (input, env))
+                         + (releaseCoefficient & SIMDType::lessThanOrEqual (input, env));
+
+        env = input + cte * (env - input);
+
+        if (envelopeOut != nullptr)
+            env.copyToRawArray (envelopeOut + i * numLanes);
+    }
+
+    return env;
+}
+
+/** Multiplies every lane of each of numFrames interleaved frames by the scale
+    of its frame */
+template <typename SampleType>
+static void scaleFrames(SampleType* frames, const SampleType* scales, size_t numFrames){
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    const auto numLanes = SIMDType::size();
+
+    for (size_t i = 0; i < numFrames; ++i)
+        (SIMDType::fromRawArray (frames + i * numLanes) * SIMDType::expand (scales[i])).copyToRawArray (frames + i * numLanes);
+}
+
+/** Sliding window RMS over numFrames interleaved frames, one channel per lane.
+    The ring holds the squares of the last windowSize frames and sums their
+    running totals. Each time the position wraps, the totals are added up
+    again from the ring, so their rounding can't drift, which still costs
+    O(1) per sample on average. Returns the position after the last frame. */
+template <typename SampleType>
+static size_t followRms(const SampleType* source, SampleType* destination, size_t numFrames,
+                        SampleType* ring, SampleType* sums, size_t windowSize, size_t position){
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    const auto numLanes = SIMDType::size();
+
+    const auto zero          = SIMDType::expand (static_cast<SampleType> (0.0));
+    const auto windowInverse = SIMDType::expand (static_cast<SampleType> (1.0) / static_cast<SampleType> (windowSize));
+
+    auto sum = SIMDType::fromRawArray (sums);
+
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        const auto input  = SIMDType::fromRawArray (source + i * numLanes);
+        const auto square = input * input;
+        auto* slot = ring + position * numLanes;
+
+        sum = sum + square - SIMDType::fromRawArray (slot);
+        square.copyToRawArray (slot);
+
+        if (++position == windowSize)
+        {
+            position = 0;
+            sum = zero;
+
+            for (size_t j = 0; j < windowSize; ++j)
+                sum = sum + SIMDType::fromRawArray (ring + j * numLanes);
+        }
+
+        SIMDType::max (sum * windowInverse, zero).copyToRawArray (destination + i * numLanes);
+    }
+
+    sum.copyToRawArray (sums);
+
+    for (size_t i = 0; i < numFrames * numLanes; ++i)
+        destination[i] = std::sqrt (destination[i]);
+
+    return position;
+}
+
+/** followRms for the linked detector signal, in place */
+template <typename SampleType>
+static size_t followLinkedRms(SampleType* detector, size_t numFrames, SampleType* ring, SampleType& sum,
+                              size_t windowSize, size_t position){
+    const auto windowInverse = static_cast<SampleType> (1.0) / static_cast<SampleType> (windowSize);
+    auto newSum = sum;
+
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        const auto square = detector[i] * detector[i];
+
+        newSum = newSum + square - ring[position];
+        ring[position] = square;
+
+        if (++position == windowSize)
+        {
+            position = 0;
+            newSum = static_cast<SampleType> (0.0);
+
+            for (size_t j = 0; j < windowSize; ++j)
+                newSum += ring[j];
+        }
+
+        const auto meanSquare = newSum * windowInverse;
+        detector[i] = std::sqrt (meanSquare > static_cast<SampleType> (0.0) ? meanSquare : static_cast<SampleType> (0.0));
+    }
+
+    sum = newSum;
+    return position;
+}
+
+/** The largest magnitude of each lane over numFrames interleaved frames */
+template <typename SampleType>
+static juce::dsp::SIMDRegister<SampleType> getFramePeaks(const SampleType* frames, size_t numFrames){
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    const auto numLanes = SIMDType::size();
+
+    auto peaks = SIMDType::expand (static_cast<SampleType> (0.0));
+
+    for (size_t i = 0; i < numFrames; ++i)
+        peaks = SIMDType::max (peaks, SIMDType::abs (SIMDType::fromRawArray (frames + i * numLanes)));
+
+    return peaks;
+}
+
+/** Folds one channel into the linked detector signal, keeping the largest
+    magnitude of every frame, or adding it up for the mean. The channel's
+    samples are stride values apart. */
+template <typename SampleType>
+static void combineDetectorChannel(SampleType* detector, const SampleType* samples, size_t stride,
+                                   size_t numFrames, bool useMaximum){
+    if (useMaximum)
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto input = std::abs (samples[i * stride]);
+            detector[i] = detector[i] < input ? input : detector[i];
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+            detector[i] += std::abs (samples[i * stride]);
+    }
+}
+
+/** Adds the samples to a running peak and sum of squares */
+template <typename SampleType>
+static void accumulateLevels(const SampleType* samples, size_t numValues, SampleType& peak, SampleType& squares){
+    auto newPeak = peak, newSquares = squares;
+
+    for (size_t i = 0; i < numValues; ++i)
+    {
+        const auto magnitude = std::abs (samples[i]);
+        newPeak     = newPeak < magnitude ? magnitude : newPeak;
+        newSquares += samples[i] * samples[i];
+    }
+
+    peak    = newPeak;
+    squares = newSquares;
+}
+
+template <typename SampleType>
+static void accumulateMinimum(const SampleType* values, size_t numValues, SampleType& minimum){
+    auto newMinimum = minimum;
+
+    for (size_t i = 0; i < numValues; ++i)
+        newMinimum = values[i] < newMinimum ? values[i] : newMinimum;
+
+    minimum = newMinimum;
+}
+
+/** applyControlRateGain for a single gain per frame, used by the linked detector */
+template <typename SampleType>
+static SampleType applyLinkedControlRateGain(SampleType* envelope, SampleType previousGain, size_t numFrames, size_t interval,
+                                             GainKernel<SampleType> applyGainKernel, const VCACoefficients<SampleType>& c){
+    for (size_t segmentStart = 0; segmentStart < numFrames; segmentStart += interval)
+    {
+        const auto segmentLength = juce::jmin (interval, numFrames - segmentStart);
+        auto* segment = envelope + segmentStart;
+
+        applyGainKernel (segment + segmentLength - 1, 1, c);
+
+        const auto target = segment[segmentLength - 1];
+        const auto step   = (target - previousGain) / static_cast<SampleType> (segmentLength);
+
+        for (size_t i = 0; i + 1 < segmentLength; ++i)
+            segment[i] = previousGain + step * static_cast<SampleType> (i + 1);
+
+        previousGain = target;
+    }
+
+    return previousGain;
+}
+
+//==============================================================================
 template <typename SampleType>
 Compressor<SampleType>::Compressor(){
     update();
@@ -20,28 +525,152 @@ Compressor<SampleType>::Compressor(){
 template <typename SampleType>
 void Compressor<SampleType>::setThreshold(SampleType newThreshold){
     thresholddB = newThreshold;
-    update();
+    needsUpdate = true;
+}
+
+/** Sets the length of the threshold ramp in seconds, 0 jumps */
+template <typename SampleType>
+void Compressor<SampleType>::setRampDurationSeconds(double newDurationSeconds){
+    rampDurationSeconds = juce::jmax (0.0, newDurationSeconds);
+    thresholdScale.reset (sampleRate, rampDurationSeconds);
 }
 
 /** Sets the ratio of the compressor **/
 template <typename SampleType>
 void Compressor<SampleType>::setRatio(SampleType newRatio){
     ratio = newRatio;
-    update();
+    needsUpdate = true;
 }
 
 /** Sets the attack time of the compressor in microseconds **/
 template <typename SampleType>
 void Compressor<SampleType>::setAttack(SampleType newAttack){
     attackTime = newAttack;
-    update();
+    needsUpdate = true;
 }
 
 /** Sets the release time of the compressor in milliseconds **/
 template <typename SampleType>
 void Compressor<SampleType>::setRelease(SampleType newRelease){
     releaseTime = newRelease;
-    update();
+    needsUpdate = true;
+}
+
+/** Sets the engine used by the VCA to compute the gain **/
+template <typename SampleType>
+void Compressor<SampleType>::setGainEngine(GainEngine newEngine){
+    gainEngine = newEngine;
+}
+
+/** Sets the width of the knee in decibels **/
+template <typename SampleType>
+void Compressor<SampleType>::setKneeWidth(SampleType newKneeWidth){
+    kneeWidthdB = newKneeWidth;
+    needsUpdate = true;
+}
+
+/** Sets what the ballistics follow **/
+template <typename SampleType>
+void Compressor<SampleType>::setDetectorMode(DetectorMode newMode){
+    detectorMode = newMode;
+}
+
+/** Sets the length of the RMS window in milliseconds **/
+template <typename SampleType>
+void Compressor<SampleType>::setRmsWindow(SampleType newWindow){
+    rmsWindowTime = newWindow;
+    updateRmsWindow();
+}
+
+/** Sets the lookahead of the compressor in milliseconds **/
+template <typename SampleType>
+void Compressor<SampleType>::setLookahead(SampleType newLookahead){
+    lookaheadTime = newLookahead;
+    updateLatency();
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setMeteringEnabled(bool shouldMeter){
+    isMetering = shouldMeter;
+}
+
+/** Sets how the detector combines the channels **/
+template <typename SampleType>
+void Compressor<SampleType>::setDetectorLink(DetectorLink newLink){
+    // The linked and the independent detectors keep separate RMS windows
+    if (newLink != detectorLink)
+        rmsHoldsHistory = false;
+
+    detectorLink = newLink;
+}
+
+/** Sets the cutoff of the detector high-pass in Hz, 0 is off **/
+template <typename SampleType>
+void Compressor<SampleType>::setDetectorHighPass(SampleType newFrequency){
+    highPassFrequency = newFrequency;
+    needsUpdate = true;
+}
+
+template <typename SampleType>
+typename Compressor<SampleType>::Coefficients Compressor<SampleType>::getCoefficients(){
+    if (needsUpdate)
+        update();
+    
+    return { thresholddB, ratio, kneeWidthdB, attackTime, releaseTime, highPassFrequency, sampleRate,
+             threshold, thresholdInverse, ratioInverse, thresholdLog2, gainExponent,
+             kneeWidth, unityGainLimit, cteAT, cteRL, highPassCoefficients };
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setCoefficients(const Coefficients& c){
+    thresholddB       = c.thresholddB;
+    ratio             = c.ratio;
+    kneeWidthdB       = c.kneeWidthdB;
+    attackTime        = c.attackTime;
+    releaseTime       = c.releaseTime;
+    highPassFrequency = c.highPassFrequency;
+    
+    if (c.sampleRate != sampleRate)
+    {
+        needsUpdate = true;
+        return;
+    }
+    
+    rampThreshold (c.threshold);
+    thresholdInverse = c.thresholdInverse;
+    ratioInverse     = c.ratioInverse;
+    thresholdLog2    = c.thresholdLog2;
+    gainExponent     = c.gainExponent;
+    kneeWidth        = c.kneeWidth;
+    unityGainLimit   = c.unityGainLimit;
+    cteAT            = c.cteAT;
+    cteRL            = c.cteRL;
+    highPassCoefficients = c.highPassCoefficients;
+    
+    needsUpdate = false;
+}
+
+/** Sets the interval of the control rate gain computer, 1 is full rate **/
+template <typename SampleType>
+void Compressor<SampleType>::setControlRateInterval(int newInterval){
+    jassert (newInterval >= 1 && newInterval <= (int) maxChunkSize);
+    controlRateInterval = (size_t) juce::jlimit (1, (int) maxChunkSize, newInterval);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setDeviationMeasurementEnabled(bool shouldMeasure){
+    isMeasuringDeviation = shouldMeasure;
+}
+
+template <typename SampleType>
+SampleType Compressor<SampleType>::getControlRateDeviationDecibels() const{
+    return juce::jmax (juce::Decibels::gainToDecibels (maxDeviationRatio, static_cast<SampleType> (-200.0)),
+                      -juce::Decibels::gainToDecibels (minDeviationRatio, static_cast<SampleType> (-200.0)));
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::resetDeviationMeasurement(){
+    minDeviationRatio = maxDeviationRatio = static_cast<SampleType> (1.0);
 }
 
 //==============================================================================
@@ -51,27 +680,577 @@ void Compressor<SampleType>::prepare(const juce::dsp::ProcessSpec& spec){
     jassert (spec.numChannels > 0);
 
     sampleRate = spec.sampleRate;
+    expFactor  = static_cast<SampleType> (-2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate);
 
-    envelopeFilter.prepare (spec);
+    // One register worth of lanes per group of channels, plus room to align the
+    // start of the storage to the SIMD register size
+    const auto numLanes = SIMDType::size();
+    numPaddedChannels   = ((spec.numChannels + numLanes - 1) / numLanes) * numLanes;
 
+    // The detector filter runs on the key channels too, which may outnumber
+    // the input channels
+    numFilterChannels = juce::jmax (numPaddedChannels, ((maxKeyChannels + numLanes - 1) / numLanes) * numLanes);
+
+    // The ring has to hold the longest lookahead plus the chunk being written
+    maxLatencySamples = static_cast<int> (std::ceil (maxLookaheadMs * 0.001 * sampleRate));
+    ringSize          = static_cast<size_t> (maxLatencySamples) + maxChunkSize;
+
+    maxRmsWindowSamples = static_cast<size_t> (std::ceil (maxRmsWindowMs * 0.001 * sampleRate));
+
+    storage.assign (2 * numPaddedChannels + 4 * maxChunkSize * numLanes
+                      + numPaddedChannels * (ringSize + maxChunkSize)
+                      + numPaddedChannels * (maxRmsWindowSamples + 1) + maxRmsWindowSamples
+                      + 2 * maxChunkSize + numLanes,
+                    static_cast<SampleType> (0.0));
+    filterStateStorage.assign (2 * numFilterChannels, 0.0);
+
+    updateLatency();
+    updateRmsWindow();
     update();
+    thresholdScale.reset (sampleRate, rampDurationSeconds);
     reset();
 }
 
 template <typename SampleType>
 void Compressor<SampleType>::reset(){
-    envelopeFilter.reset();
+    // Straight to the threshold that was set
+    thresholdScale.setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+
+    if (storage.empty())
+        return;
+
+    std::fill (storage.begin(), storage.end(), static_cast<SampleType> (0.0));
+    std::fill (filterStateStorage.begin(), filterStateStorage.end(), 0.0);
+
+    // A silent envelope means unity gain
+    auto* controlGainState = getBuffers().controlGainState;
+    std::fill (controlGainState, controlGainState + numPaddedChannels, static_cast<SampleType> (1.0));
+    
+    linkedEnvelopeState    = static_cast<SampleType> (0.0);
+    linkedControlGainState = static_cast<SampleType> (1.0);
+    
+    // The ring is all silence now, which is the right history for any lookahead
+    ringWritePosition = 0;
+    ringHoldsHistory  = true;
+    
+    filterHoldsState = false;
+    rmsHoldsHistory  = false;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setSampleRate(double newSampleRate){
+    jassert (newSampleRate > 0);
+
+    // The lookahead ring and the RMS windows hold samples of the old rate,
+    // so both start again from silence
+    if (newSampleRate != sampleRate)
+    {
+        ringHoldsHistory = false;
+        rmsHoldsHistory  = false;
+    }
+
+    sampleRate  = newSampleRate;
+    expFactor   = static_cast<SampleType> (-2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate);
+    needsUpdate = true;
+
+    thresholdScale.reset (sampleRate, rampDurationSeconds);
+    updateLatency();
+    updateRmsWindow();
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::copyStateFrom(const Compressor& other){
+    jassert (storage.size() == other.storage.size());
+
+    // Same size, so the storage is copied into the memory it already has
+    *this = other;
+
+    if (storage.empty())
+        return;
+
+    // The aligned start may sit at another index in this storage than in the
+    // other one. The storage has a register of slack, so either fits.
+    auto* source = const_cast<SampleType*> (other.storage.data());
+    const auto sourceOffset = static_cast<size_t> (SIMDType::getNextSIMDAlignedPtr (source) - source);
+    const auto targetOffset = static_cast<size_t> (SIMDType::getNextSIMDAlignedPtr (storage.data()) - storage.data());
+
+    if (sourceOffset != targetOffset)
+        std::memmove (storage.data() + targetOffset, storage.data() + sourceOffset,
+                      (storage.size() - SIMDType::size()) * sizeof (SampleType));
 }
 
 //==============================================================================
+template <typename SampleType>
+void Compressor<SampleType>::processBlock(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                          const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                                          const SampleType* inputGains,
+                                          const SampleType* outputGains,
+                                          const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                                          int keyRateShift){
+    COMPRESSOR_TRACE_STAGE ("Compressor::processBlock");
+
+    const auto numChannels = outputBlock.getNumChannels();
+    const auto numSamples  = outputBlock.getNumSamples();
+    const auto numLanes    = SIMDType::size();
+
+    jassert (numChannels <= numPaddedChannels);
+
+    const auto useKey = keyBlock.getNumChannels() > 0;
+
+    jassert (! useKey || keyBlock.getNumSamples() << keyRateShift >= numSamples);
+
+    if (needsUpdate)
+        update();
+
+    // The ring is only written while the lookahead is on. Turning it on again
+    // starts from silence rather than from a stale history.
+    const auto useLookahead = lookaheadSamples > 0;
+
+    if (useLookahead && ! ringHoldsHistory)
+    {
+        auto* ring = getBuffers().lookaheadRing;
+        std::fill (ring, ring + numPaddedChannels * (ringSize + maxChunkSize), static_cast<SampleType> (0.0));
+    }
+
+    ringHoldsHistory = useLookahead;
+
+    prepareDetectorFilter (getBuffers(), useKey);
+    prepareRmsWindow (getBuffers());
+
+    if (detectorLink != DetectorLink::independent)
+    {
+        processLinkedBlock (inputBlock, outputBlock, inputGains, outputGains, keyBlock, keyRateShift);
+        return;
+    }
+
+    const auto buffers = getBuffers();
+    const auto useFilter = highPassFrequency > 0;
+    const auto useRms    = detectorMode == DetectorMode::rms;
+
+    // A key that is neither mono nor one channel per input channel is folded
+    // into one detector signal, already rectified and filtered, for every lane
+    const auto numKeyChannels = juce::jmin (keyBlock.getNumChannels(), maxKeyChannels);
+    const auto foldKey = useKey && numKeyChannels != 1 && numKeyChannels != numChannels;
+    auto* envelopeState       = buffers.envelopeState;
+    auto* interleavedEnvelope = buffers.interleavedEnvelope;
+
+    const auto attackCoefficient  = SIMDType::expand (cteAT);
+    const auto releaseCoefficient = SIMDType::expand (cteRL);
+
+    const auto applyGainKernel = getGainKernel<SampleType> (gainEngine, ratio, kneeWidth);
+    const auto vcaCoefficients = getVCACoefficients();
+
+    for (size_t startSample = 0; startSample < numSamples; startSample += maxChunkSize)
+    {
+        const auto chunkSize = juce::jmin (maxChunkSize, numSamples - startSample);
+        const auto readPosition = (ringWritePosition + ringSize - static_cast<size_t> (lookaheadSamples)) % ringSize;
+        auto nextRmsPosition = rmsPosition;
+
+        // Shared by every group of channels
+        auto maxEnvelopeScale = static_cast<SampleType> (1.0);
+        const auto* envelopeScales = fillEnvelopeScales (buffers, chunkSize, maxEnvelopeScale);
+        const auto maxEnvelopeScales = SIMDType::expand (maxEnvelopeScale);
+
+        if (foldKey)
+            combineDetectorChunk (buffers, buffers.foldedKey, inputBlock, keyBlock, numKeyChannels,
+                                  startSample, chunkSize, keyRateShift);
+
+        for (size_t firstChannel = 0; firstChannel < numChannels; firstChannel += numLanes)
+        {
+            const auto numActiveLanes = juce::jmin (numLanes, numChannels - firstChannel);
+
+            // Measured before anything is written, the output may be the input
+            if (isMetering)
+            {
+                for (size_t lane = 0; lane < numActiveLanes; ++lane)
+                    accumulateLevels (inputBlock.getChannelPointer (firstChannel + lane) + startSample, chunkSize,
+                                      levels.inputPeak, levels.inputSquares);
+            }
+
+            // With lookahead the input goes straight into the ring. The detector
+            // reads the newest frames, the output the frames lookaheadSamples
+            // behind them, so both share the one buffer.
+            auto* ring = getRingFrames (buffers, firstChannel);
+            auto* interleavedInput = useLookahead ? ring + ringWritePosition * numLanes
+                                                  : buffers.interleavedInput;
+
+            interleaveChunk (interleavedInput, inputBlock, firstChannel, numActiveLanes, numLanes,
+                             startSample, chunkSize, inputGains);
+
+            if (useLookahead)
+                mirrorRingFrames (ring, ringSize, maxChunkSize, ringWritePosition, chunkSize, numLanes);
+
+            const auto* delayedInput = useLookahead ? ring + readPosition * numLanes
+                                                    : interleavedInput;
+
+            // The key and the filtered input get frames of their own, so the
+            // audio frames stay as they are for the output
+            const SampleType* detectorInput = interleavedInput;
+
+            if (foldKey)
+            {
+                broadcastChunk (buffers.detectorInput, buffers.foldedKey, numActiveLanes, numLanes, chunkSize);
+                detectorInput = buffers.detectorInput;
+            }
+            else if (useKey)
+            {
+                interleaveKeyChunk (buffers.detectorInput, keyBlock, firstChannel, numActiveLanes, numLanes,
+                                    startSample, chunkSize, keyRateShift);
+                detectorInput = buffers.detectorInput;
+            }
+
+            if (useFilter && ! foldKey)
+            {
+                filterFrames (detectorInput, buffers.detectorInput, chunkSize, buffers.filterState + firstChannel,
+                              buffers.filterState + numFilterChannels + firstChannel, highPassCoefficients);
+                detectorInput = buffers.detectorInput;
+            }
+
+            // Every group starts from the same position, and ends on the same
+            if (useRms)
+            {
+                nextRmsPosition = followRms (detectorInput, buffers.detectorInput, chunkSize,
+                                             buffers.rmsRing + firstChannel * maxRmsWindowSamples,
+                                             buffers.rmsSums + firstChannel, rmsWindowSamples, rmsPosition);
+                detectorInput = buffers.detectorInput;
+            }
+
+            auto env = SIMDType::fromRawArray (envelopeState + firstChannel);
+            auto* controlGains = buffers.controlGainState + firstChannel;
+
+            const auto fastPath = getFastPath (getFramePeaks (detectorInput, chunkSize) * maxEnvelopeScales,
+                                               env * maxEnvelopeScales, controlGains);
+
+            if (fastPath != FastPath::none)
+            {
+                // The gain is exactly 1 for the whole chunk, only the envelope
+                // has to move on, and not even that when it's all zeros
+                if (fastPath == FastPath::belowThreshold)
+                {
+                    env = followEnvelope<SampleType> (detectorInput, chunkSize, env, attackCoefficient, releaseCoefficient, nullptr);
+                    env.copyToRawArray (envelopeState + firstChannel);
+                }
+
+                std::fill (interleavedEnvelope, interleavedEnvelope + chunkSize * numLanes, static_cast<SampleType> (1.0));
+            }
+            else
+            {
+                // Ballistics filter with peak rectifier, same arithmetic as processSample
+                env = followEnvelope<SampleType> (detectorInput, chunkSize, env, attackCoefficient, releaseCoefficient, interleavedEnvelope);
+                env.copyToRawArray (envelopeState + firstChannel);
+
+                if (envelopeScales != nullptr)
+                    scaleFrames (interleavedEnvelope, envelopeScales, chunkSize);
+
+                // VCA, over the contiguous envelope buffer
+                if (controlRateInterval > 1)
+                {
+                    if (isMeasuringDeviation)
+                    {
+                        std::copy (interleavedEnvelope, interleavedEnvelope + chunkSize * numLanes, buffers.fullRateGains);
+                        applyGainKernel (buffers.fullRateGains, chunkSize * numLanes, vcaCoefficients);
+                    }
+
+                    applyControlRateGain (interleavedEnvelope, controlGains, chunkSize, controlRateInterval, applyGainKernel, vcaCoefficients);
+
+                    if (isMeasuringDeviation)
+                        measureDeviation (interleavedEnvelope, buffers.fullRateGains, chunkSize * numLanes);
+                }
+                else
+                {
+                    applyGainKernel (interleavedEnvelope, chunkSize * numLanes, vcaCoefficients);
+
+                    // Keep the last gain, in case the next block runs at control rate
+                    const auto* lastFrame = interleavedEnvelope + (chunkSize - 1) * numLanes;
+                    std::copy (lastFrame, lastFrame + numLanes, controlGains);
+                }
+
+                // Lanes without a channel have unity gain, so they don't count
+                if (isMetering)
+                    accumulateMinimum (interleavedEnvelope, chunkSize * numLanes, levels.minGain);
+            }
+
+            for (size_t lane = 0; lane < numActiveLanes; ++lane)
+            {
+                auto* outputSamples = outputBlock.getChannelPointer (firstChannel + lane) + startSample;
+
+                if (outputGains != nullptr)
+                {
+                    for (size_t i = 0; i < chunkSize; ++i)
+                        outputSamples[i] = interleavedEnvelope[i * numLanes + lane] * delayedInput[i * numLanes + lane] * outputGains[startSample + i];
+                }
+                else
+                {
+                    for (size_t i = 0; i < chunkSize; ++i)
+                        outputSamples[i] = interleavedEnvelope[i * numLanes + lane] * delayedInput[i * numLanes + lane];
+                }
+
+                if (isMetering)
+                    accumulateLevels (outputSamples, chunkSize, levels.outputPeak, levels.outputSquares);
+            }
+
+            if (isMetering)
+                levels.numValues += chunkSize * numActiveLanes;
+        }
+
+        if (useLookahead)
+            ringWritePosition = (ringWritePosition + chunkSize) % ringSize;
+
+        rmsPosition = nextRmsPosition;
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::processLinkedBlock(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                                const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                                                const SampleType* inputGains,
+                                                const SampleType* outputGains,
+                                                const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                                                int keyRateShift){
+    const auto numChannels = outputBlock.getNumChannels();
+    const auto numSamples  = outputBlock.getNumSamples();
+    const auto numLanes    = SIMDType::size();
+    const auto useLookahead = lookaheadSamples > 0;
+    const auto useKey       = keyBlock.getNumChannels() > 0;
+
+    const auto buffers = getBuffers();
+    auto* detector = buffers.interleavedInput;
+    auto* gains    = buffers.interleavedEnvelope;
+
+    // The detector combines the channels of the key when there is one, all
+    // of them whatever their number
+    const auto numDetectorChannels = useKey ? juce::jmin (keyBlock.getNumChannels(), maxKeyChannels) : numChannels;
+
+    const auto applyGainKernel = getGainKernel<SampleType> (gainEngine, ratio, kneeWidth);
+    const auto vcaCoefficients = getVCACoefficients();
+
+    for (size_t startSample = 0; startSample < numSamples; startSample += maxChunkSize)
+    {
+        const auto chunkSize = juce::jmin (maxChunkSize, numSamples - startSample);
+        const auto* chunkInputGains  = inputGains  != nullptr ? inputGains  + startSample : nullptr;
+        const auto* chunkOutputGains = outputGains != nullptr ? outputGains + startSample : nullptr;
+
+        auto maxEnvelopeScale = static_cast<SampleType> (1.0);
+        const auto* envelopeScales = fillEnvelopeScales (buffers, chunkSize, maxEnvelopeScale);
+
+        if (isMetering)
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                accumulateLevels (inputBlock.getChannelPointer (channel) + startSample, chunkSize,
+                                  levels.inputPeak, levels.inputSquares);
+
+        // Detector signal, the rectified input combined across the channels.
+        // The input gain is positive, so it can be applied after combining.
+        combineDetectorChunk (buffers, detector, inputBlock, keyBlock, numDetectorChannels,
+                              startSample, chunkSize, keyRateShift);
+
+        if (chunkInputGains != nullptr && ! useKey)
+            for (size_t i = 0; i < chunkSize; ++i)
+                detector[i] *= chunkInputGains[i];
+
+        if (detectorMode == DetectorMode::rms)
+            rmsPosition = followLinkedRms (detector, chunkSize, buffers.linkedRmsRing, linkedRmsSum,
+                                           rmsWindowSamples, rmsPosition);
+
+        auto detectorPeak = static_cast<SampleType> (0.0);
+
+        for (size_t i = 0; i < chunkSize; ++i)
+            detectorPeak = detectorPeak < detector[i] ? detector[i] : detectorPeak;
+
+        const auto fastPath = getFastPath (detectorPeak * maxEnvelopeScale, linkedEnvelopeState * maxEnvelopeScale,
+                                           linkedControlGainState);
+        auto env = linkedEnvelopeState;
+
+        if (fastPath != FastPath::none)
+        {
+            // Unity gain for the whole chunk, see processBlock()
+            if (fastPath == FastPath::belowThreshold)
+            {
+                for (size_t i = 0; i < chunkSize; ++i)
+                {
+                    const auto input = detector[i];
+                    const auto cte   = (input > env ? cteAT : cteRL);
+                    env = input + cte * (env - input);
+                }
+            }
+
+            std::fill (gains, gains + chunkSize, static_cast<SampleType> (1.0));
+        }
+        else
+        {
+            // Ballistics filter, same arithmetic as processSample
+            for (size_t i = 0; i < chunkSize; ++i)
+            {
+                const auto input = detector[i];
+                const auto cte   = (input > env ? cteAT : cteRL);
+                env = input + cte * (env - input);
+                gains[i] = env;
+            }
+
+            if (envelopeScales != nullptr)
+                for (size_t i = 0; i < chunkSize; ++i)
+                    gains[i] *= envelopeScales[i];
+
+            // VCA, once per frame
+            if (controlRateInterval > 1)
+            {
+                if (isMeasuringDeviation)
+                {
+                    std::copy (gains, gains + chunkSize, buffers.fullRateGains);
+                    applyGainKernel (buffers.fullRateGains, chunkSize, vcaCoefficients);
+                }
+
+                linkedControlGainState = applyLinkedControlRateGain (gains, linkedControlGainState, chunkSize,
+                                                                     controlRateInterval, applyGainKernel, vcaCoefficients);
+
+                if (isMeasuringDeviation)
+                    measureDeviation (gains, buffers.fullRateGains, chunkSize);
+            }
+            else
+            {
+                applyGainKernel (gains, chunkSize, vcaCoefficients);
+                linkedControlGainState = gains[chunkSize - 1];
+            }
+
+            if (isMetering)
+                accumulateMinimum (gains, chunkSize, levels.minGain);
+        }
+
+        linkedEnvelopeState = env;
+
+        // Fold the gain stages into one gain per frame, then apply it to every
+        // channel. With lookahead the input gain was applied on the way into the
+        // ring, and the channels are read back from it delayed.
+        if (chunkInputGains != nullptr && ! useLookahead)
+            for (size_t i = 0; i < chunkSize; ++i)
+                gains[i] *= chunkInputGains[i];
+
+        if (chunkOutputGains != nullptr)
+            for (size_t i = 0; i < chunkSize; ++i)
+                gains[i] *= chunkOutputGains[i];
+
+        if (useLookahead)
+        {
+            const auto readPosition = (ringWritePosition + ringSize - static_cast<size_t> (lookaheadSamples)) % ringSize;
+
+            for (size_t firstChannel = 0; firstChannel < numChannels; firstChannel += numLanes)
+            {
+                const auto numActiveLanes = juce::jmin (numLanes, numChannels - firstChannel);
+                auto* ring = getRingFrames (buffers, firstChannel);
+
+                interleaveChunk (ring + ringWritePosition * numLanes, inputBlock, firstChannel, numActiveLanes, numLanes,
+                                 startSample, chunkSize, inputGains);
+                mirrorRingFrames (ring, ringSize, maxChunkSize, ringWritePosition, chunkSize, numLanes);
+
+                const auto* delayedInput = ring + readPosition * numLanes;
+
+                for (size_t lane = 0; lane < numActiveLanes; ++lane)
+                {
+                    auto* outputSamples = outputBlock.getChannelPointer (firstChannel + lane) + startSample;
+
+                    for (size_t i = 0; i < chunkSize; ++i)
+                        outputSamples[i] = delayedInput[i * numLanes + lane] * gains[i];
+
+                    if (isMetering)
+                        accumulateLevels (outputSamples, chunkSize, levels.outputPeak, levels.outputSquares);
+                }
+            }
+
+            ringWritePosition = (ringWritePosition + chunkSize) % ringSize;
+        }
+        else
+        {
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* inputSamples = inputBlock.getChannelPointer (channel) + startSample;
+                auto* outputSamples      = outputBlock.getChannelPointer (channel) + startSample;
+
+                for (size_t i = 0; i < chunkSize; ++i)
+                    outputSamples[i] = inputSamples[i] * gains[i];
+
+                if (isMetering)
+                    accumulateLevels (outputSamples, chunkSize, levels.outputPeak, levels.outputSquares);
+            }
+        }
+
+        if (isMetering)
+            levels.numValues += chunkSize * numChannels;
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::combineDetectorChunk(const Buffers& buffers, SampleType* detector,
+                                                  const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                                  const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                                                  size_t numDetectorChannels, size_t startSample, size_t chunkSize,
+                                                  int keyRateShift){
+    const auto numLanes  = SIMDType::size();
+    const auto useKey    = keyBlock.getNumChannels() > 0;
+    const auto useFilter = highPassFrequency > 0;
+    const auto useMaximum = detectorLink != DetectorLink::mean;
+
+    std::fill (detector, detector + chunkSize, static_cast<SampleType> (0.0));
+
+    if (useKey || useFilter)
+    {
+        // Through interleaved frames, so the filter runs on every lane at once
+        auto* frames = buffers.detectorInput;
+
+        for (size_t firstChannel = 0; firstChannel < numDetectorChannels; firstChannel += numLanes)
+        {
+            const auto numActiveLanes = juce::jmin (numLanes, numDetectorChannels - firstChannel);
+
+            if (useKey)
+                interleaveKeyChunk (frames, keyBlock, firstChannel, numActiveLanes, numLanes,
+                                    startSample, chunkSize, keyRateShift);
+            else
+                interleaveChunk (frames, inputBlock, firstChannel, numActiveLanes, numLanes,
+                                 startSample, chunkSize, static_cast<const SampleType*> (nullptr));
+
+            if (useFilter)
+                filterFrames (frames, frames, chunkSize, buffers.filterState + firstChannel,
+                              buffers.filterState + numFilterChannels + firstChannel, highPassCoefficients);
+
+            for (size_t lane = 0; lane < numActiveLanes; ++lane)
+                combineDetectorChannel (detector, frames + lane, numLanes, chunkSize, useMaximum);
+        }
+    }
+    else
+    {
+        for (size_t channel = 0; channel < numDetectorChannels; ++channel)
+            combineDetectorChannel (detector, inputBlock.getChannelPointer (channel) + startSample, 1, chunkSize, useMaximum);
+    }
+
+    if (! useMaximum)
+    {
+        const auto channelWeight = static_cast<SampleType> (1.0) / static_cast<SampleType> (numDetectorChannels);
+
+        for (size_t i = 0; i < chunkSize; ++i)
+            detector[i] *= channelWeight;
+    }
+}
+
 template <typename SampleType>
 SampleType Compressor<SampleType>::processSample(int channel, SampleType inputValue){
+    jassert (juce::isPositiveAndBelow ((size_t) channel, numPaddedChannels));
+
+    if (needsUpdate)
+        update();
+
     // Ballistics filter with peak rectifier
-    auto env = envelopeFilter.processSample (channel, inputValue);
+    auto& state = getBuffers().envelopeState[channel];
+    auto input  = std::abs (inputValue);
+    auto cte    = (input > state ? cteAT : cteRL);
+    auto env    = input + cte * (state - input);
+    state = env;
 
     // VCA
-    auto gain = (env < threshold) ? static_cast<float> (1.0)
-                                  : std::pow (env * thresholdInverse, ratioInverse - static_cast<float> (1.0));
+    const auto c = getVCACoefficients();
+    SampleType gain;
+
+    if (kneeWidth > static_cast<SampleType> (0.0))
+        gain = (gainEngine == GainEngine::exact) ? softKneeGain<false> (env, c) : softKneeGain<true> (env, c);
+    else
+        gain = (gainEngine == GainEngine::exact) ? exactGain (env, c) : approximateGain (env, c);
     
     return gain * inputValue;
 }
@@ -79,12 +1258,196 @@ SampleType Compressor<SampleType>::processSample(int channel, SampleType inputVa
 //==============================================================================
 template <typename SampleType>
 void Compressor<SampleType>::update(){
-    threshold = juce::Decibels::decibelsToGain(thresholddB, static_cast<float> (-200.0));
-    thresholdInverse = static_cast<float> (1.0) / threshold;
-    ratioInverse     = static_cast<float> (1.0) / ratio;
+    COMPRESSOR_TRACE_STAGE ("Compressor::update");
+    
+    rampThreshold (juce::Decibels::decibelsToGain(thresholddB, static_cast<SampleType> (-200.0)));
+    thresholdInverse = static_cast<SampleType> (1.0) / threshold;
+    ratioInverse     = static_cast<SampleType> (1.0) / ratio;
+    
+    thresholdLog2 = FastMath::log2 (threshold);
+    gainExponent  = ratioInverse - static_cast<SampleType> (1.0);
+    
+    // dB to octaves. Below the start of the knee every kernel returns exactly
+    // 1, the margin covers the rounding of the envelope and of the log2.
+    kneeWidth = kneeWidthdB > static_cast<SampleType> (0.0) ? kneeWidthdB / static_cast<SampleType> (20.0 * std::log10 (2.0))
+                                                            : static_cast<SampleType> (0.0);
+    unityGainLimit = threshold * std::exp2 (kneeWidth * static_cast<SampleType> (-0.5)) * static_cast<SampleType> (0.999);
+    
+    cteAT = calculateLimitedCte (attackTime);
+    cteRL = calculateLimitedCte (releaseTime);
+    
+    // RBJ cookbook high-pass, Q = 1 / sqrt (2)
+    if (highPassFrequency > 0)
+    {
+        const auto frequency = juce::jmin (static_cast<double> (highPassFrequency), 0.45 * sampleRate);
+        const auto w0    = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+        const auto cosw0 = std::cos (w0);
+        const auto alpha = std::sin (w0) / std::sqrt (2.0);
+        const auto a0Inverse = 1.0 / (1.0 + alpha);
+        
+        highPassCoefficients = {  0.5 * (1.0 + cosw0) * a0Inverse,
+                                 -(1.0 + cosw0) * a0Inverse,
+                                  0.5 * (1.0 + cosw0) * a0Inverse,
+                                 -2.0 * cosw0 * a0Inverse,
+                                 (1.0 - alpha) * a0Inverse };
+    }
     
-    envelopeFilter.setAttackTime (attackTime);
-    envelopeFilter.setReleaseTime (releaseTime);
+    needsUpdate = false;
+}
+
+template <typename SampleType>
+typename Compressor<SampleType>::FastPath Compressor<SampleType>::getFastPath(SampleType peak, SampleType envelope,
+                                                                              SampleType controlGain) const{
+    if (controlGain != static_cast<SampleType> (1.0))
+        return FastPath::none;
+
+    if (peak == static_cast<SampleType> (0.0) && envelope == static_cast<SampleType> (0.0))
+        return FastPath::silence;
+
+    // The envelope never leaves the range between its start and the peak of
+    // the input, so it stays where every kernel returns exactly 1
+    return (peak < unityGainLimit && envelope < unityGainLimit) ? FastPath::belowThreshold : FastPath::none;
+}
+
+template <typename SampleType>
+typename Compressor<SampleType>::FastPath Compressor<SampleType>::getFastPath(SIMDType peaks, SIMDType envelopes,
+                                                                              const SampleType* controlGains) const{
+    auto result = FastPath::silence;
+
+    for (size_t lane = 0; lane < SIMDType::size(); ++lane)
+    {
+        const auto lanePath = getFastPath (peaks.get (lane), envelopes.get (lane), controlGains[lane]);
+
+        if (lanePath == FastPath::none)
+            return FastPath::none;
+
+        if (lanePath == FastPath::belowThreshold)
+            result = FastPath::belowThreshold;
+    }
+
+    return result;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::prepareDetectorFilter(const Buffers& buffers, bool useKey){
+    const auto useFilter = highPassFrequency > 0;
+
+    // A state left from another signal would ring through the detector
+    if (useFilter && (! filterHoldsState || useKey != filterFollowsKey))
+        std::fill (buffers.filterState, buffers.filterState + 2 * numFilterChannels, 0.0);
+
+    filterHoldsState = useFilter;
+    filterFollowsKey = useKey;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::prepareRmsWindow(const Buffers& buffers){
+    const auto useRms = detectorMode == DetectorMode::rms;
+
+    if (useRms && ! rmsHoldsHistory)
+    {
+        std::fill (buffers.rmsSums, buffers.rmsSums + numPaddedChannels * (maxRmsWindowSamples + 1) + maxRmsWindowSamples,
+                   static_cast<SampleType> (0.0));
+        linkedRmsSum = static_cast<SampleType> (0.0);
+        rmsPosition  = 0;
+    }
+
+    rmsHoldsHistory = useRms;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateRmsWindow(){
+    const auto samples = static_cast<size_t> (juce::jmax (1, juce::roundToInt (static_cast<double> (rmsWindowTime) * 0.001 * sampleRate)));
+    const auto newWindowSamples = juce::jmin (samples, maxRmsWindowSamples);
+
+    // A window of another length needs its own history
+    if (newWindowSamples != rmsWindowSamples)
+        rmsHoldsHistory = false;
+
+    rmsWindowSamples = newWindowSamples;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateLatency(){
+    const auto samples = juce::roundToInt (static_cast<double> (lookaheadTime) * 0.001 * sampleRate);
+    lookaheadSamples = juce::jlimit (0, maxLatencySamples, samples);
+}
+
+template <typename SampleType>
+SampleType Compressor<SampleType>::calculateLimitedCte(SampleType timeMs) const{
+    return timeMs < static_cast<SampleType> (1.0e-3) ? 0
+                                                     : static_cast<SampleType> (std::exp (expFactor / timeMs));
+}
+
+template <typename SampleType>
+VCACoefficients<SampleType> Compressor<SampleType>::getVCACoefficients() const{
+    return { threshold, thresholdInverse, thresholdLog2, gainExponent, kneeWidth,
+             kneeWidth > static_cast<SampleType> (0.0) ? static_cast<SampleType> (0.5) / kneeWidth : static_cast<SampleType> (0.0) };
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::rampThreshold(SampleType newThreshold){
+    if (newThreshold == threshold)
+        return;
+
+    // The VCA is at threshold / scale, the ramp goes on from there
+    thresholdScale.setCurrentAndTargetValue (thresholdScale.getCurrentValue() * newThreshold / threshold);
+    thresholdScale.setTargetValue (static_cast<SampleType> (1.0));
+    threshold = newThreshold;
+}
+
+template <typename SampleType>
+const SampleType* Compressor<SampleType>::fillEnvelopeScales(const Buffers& buffers, size_t chunkSize, SampleType& maxScale){
+    if (! thresholdScale.isSmoothing())
+        return nullptr;
+
+    thresholdScale.fill (buffers.envelopeScales, chunkSize);
+
+    // Linear, so the largest is at one of the ends
+    maxScale = juce::jmax (buffers.envelopeScales[0], buffers.envelopeScales[chunkSize - 1]);
+    return buffers.envelopeScales;
+}
+
+template <typename SampleType>
+typename Compressor<SampleType>::Buffers Compressor<SampleType>::getBuffers(){
+    const auto frameSize = maxChunkSize * SIMDType::size();
+
+    Buffers buffers;
+    buffers.envelopeState       = SIMDType::getNextSIMDAlignedPtr (storage.data());
+    buffers.controlGainState    = buffers.envelopeState + numPaddedChannels;
+    buffers.filterState         = filterStateStorage.data();
+    buffers.interleavedInput    = buffers.controlGainState + numPaddedChannels;
+    buffers.interleavedEnvelope = buffers.interleavedInput + frameSize;
+    buffers.fullRateGains       = buffers.interleavedEnvelope + frameSize;
+    buffers.detectorInput       = buffers.fullRateGains + frameSize;
+    buffers.lookaheadRing       = buffers.detectorInput + frameSize;
+    buffers.rmsSums             = buffers.lookaheadRing + numPaddedChannels * (ringSize + maxChunkSize);
+    buffers.rmsRing             = buffers.rmsSums + numPaddedChannels;
+    buffers.linkedRmsRing       = buffers.rmsRing + numPaddedChannels * maxRmsWindowSamples;
+    buffers.envelopeScales      = buffers.linkedRmsRing + maxRmsWindowSamples;
+    buffers.foldedKey           = buffers.envelopeScales + maxChunkSize;
+
+    return buffers;
+}
+
+template <typename SampleType>
+SampleType* Compressor<SampleType>::getRingFrames(const Buffers& buffers, size_t firstChannel) const{
+    return buffers.lookaheadRing + firstChannel * (ringSize + maxChunkSize);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::measureDeviation(const SampleType* gains, const SampleType* fullRateGains, size_t numValues){
+    auto minRatio = minDeviationRatio, maxRatio = maxDeviationRatio;
+
+    for (size_t i = 0; i < numValues; ++i)
+    {
+        const auto gainRatio = gains[i] / fullRateGains[i];
+        minRatio = juce::jmin (minRatio, gainRatio);
+        maxRatio = juce::jmax (maxRatio, gainRatio);
+    }
+
+    minDeviationRatio = minRatio;
+    maxDeviationRatio = maxRatio;
 }
 
 //==============================================================================
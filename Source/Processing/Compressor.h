@@ -13,6 +13,49 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "FastMath.h"
+#include "ParameterRamp.h"
+#include "Tracing.h"
+
+/** How the VCA turns the envelope into a gain.
+
+    exact             evaluates std::pow for every sample above the threshold
+    fastApproximation works in the log2 domain with the polynomials from
+                      FastMath.h, see there for how far it is from exact
+*/
+enum class GainEngine { exact, fastApproximation };
+
+/** How the detector combines the channels.
+
+    independent  every channel has its own envelope and gain
+    maximum      one envelope follows the loudest channel of each frame
+    mean         one envelope follows the average level of each frame
+
+    The linked modes compute one gain per frame and apply it to every channel,
+    so the stereo (or surround) image doesn't shift under compression.
+*/
+enum class DetectorLink { independent, maximum, mean };
+
+/** What the ballistics follow.
+
+    peak  the rectified detector signal
+    rms   its RMS over a sliding window, see Compressor::setRmsWindow()
+*/
+enum class DetectorMode { peak, rms };
+
+/** Normalized biquad coefficients, for the transposed direct form II */
+template <typename SampleType>
+struct BiquadCoefficients {
+    SampleType b0, b1, b2, a1, a2;
+};
+
+/** Everything the VCA needs to turn an envelope value into a gain. The knee
+    is in octaves of the envelope, kneeScale is 1 / (2 * kneeWidth). */
+template <typename SampleType>
+struct VCACoefficients {
+    SampleType threshold, thresholdInverse, thresholdLog2, exponent;
+    SampleType kneeWidth, kneeScale;
+};
 
 template <typename SampleType>
 class Compressor {
@@ -21,9 +64,17 @@ public:
     Compressor();
     
     //==============================================================================
-    /** Sets the threshold of the compressor in decibels */
+    // The setters only store the new value. The coefficients are recomputed once,
+    // at the start of the next processed block, however many values changed.
+    
+    /** Sets the threshold of the compressor in decibels. processBlock() ramps
+        to it, see setRampDurationSeconds(). */
     void setThreshold (SampleType newThreshold);
     
+    /** Sets how long processBlock() takes to move to a new threshold, so
+        automating it doesn't zipper. 0, the default, jumps. **/
+    void setRampDurationSeconds (double newDurationSeconds);
+    
     /** Sets the ratio of the compressor **/
     void setRatio (SampleType newRatio);
     
@@ -33,12 +84,129 @@ public:
     /** Sets the release time of the compressor in milliseconds **/
     void setRelease (SampleType newRelease);
     
+    /** Sets the engine used by the VCA to compute the gain **/
+    void setGainEngine (GainEngine newEngine);
+    
+    /** Sets the width of the knee in decibels, centered on the threshold. The
+        curve bends quadratically from 1:1 to the ratio across it. 0 is a
+        hard knee. **/
+    void setKneeWidth (SampleType newKneeWidth);
+    
+    /** Sets what the ballistics follow, the peak or the RMS level **/
+    void setDetectorMode (DetectorMode newMode);
+    
+    /** Sets the length of the RMS window in milliseconds, up to
+        maxRmsWindowMs. The window is allocated in prepare(). **/
+    void setRmsWindow (SampleType newWindow);
+    
+    static constexpr double maxRmsWindowMs = 50.0;
+    
+    /** Delays the audio against the detector by newLookahead milliseconds, so
+        the gain is already down when a transient reaches the output. Up to
+        maxLookaheadMs, the delay line is allocated in prepare(). **/
+    void setLookahead (SampleType newLookahead);
+    
+    /** The delay added by the lookahead, in samples. Unlike the other
+        settings this changes as soon as setLookahead() is called. **/
+    int getLatencySamples () const { return lookaheadSamples; }
+    
+    static constexpr double maxLookaheadMs = 10.0;
+    
+    /** The widest key the detector reads, see processBlock() */
+    static constexpr size_t maxKeyChannels = 64;
+    
+    /** Levels seen by processBlock() since the last resetLevels(), summed over
+        every channel. The input is measured before the input gain. */
+    struct Levels {
+        SampleType inputPeak = 0, inputSquares = 0;
+        SampleType outputPeak = 0, outputSquares = 0;
+        SampleType minGain = 1;
+        size_t numValues = 0;    // samples per channel times channels
+    };
+    
+    /** While enabled, processBlock() records the Levels of what it processes.
+        Off by default, it costs a pass over the input and the output. **/
+    void setMeteringEnabled (bool shouldMeter);
+    
+    const Levels& getLevels () const { return levels; }
+    
+    void resetLevels () { levels = {}; }
+    
+    /** Sets how the detector combines the channels. processSample() always
+        works on a single channel, so it ignores this. **/
+    void setDetectorLink (DetectorLink newLink);
+    
+    /** High-passes the detector signal (the input or the key) at newFrequency
+        Hz with a 12 dB/oct Butterworth filter, so low end doesn't pump the
+        gain. The audio itself isn't filtered. 0 turns the filter off. **/
+    void setDetectorHighPass (SampleType newFrequency);
+    
+    /** Evaluates the gain computer only on every newInterval-th sample and
+        interpolates the gain linearly in between. 1 (the default) is exact full
+        rate processing, larger intervals trade accuracy for a cheaper VCA.
+        Must be between 1 and maxChunkSize. The intervals restart with every
+        chunk of maxChunkSize samples of a block, so the last sample of each
+        chunk always gets its exact gain. **/
+    void setControlRateInterval (int newInterval);
+    
+    /** Number of samples per channel handled by one pass of the block kernel,
+        small enough for the interleaved scratch buffers to stay in L1. */
+    static constexpr size_t maxChunkSize = 64;
+    
+    /** When enabled, processBlock() also computes the full rate gain of every
+        sample it interpolates, and records how far the two are apart. This
+        costs as much as full rate processing, so use it to pick an interval,
+        not in a live chain. **/
+    void setDeviationMeasurementEnabled (bool shouldMeasure);
+    
+    /** Returns the largest difference between the interpolated and the full
+        rate gain, in decibels, since the last call to resetDeviationMeasurement() **/
+    SampleType getControlRateDeviationDecibels () const;
+    
+    void resetDeviationMeasurement ();
+    
+    /** What update() computes from the threshold, ratio, knee, attack, release
+        and detector high-pass at one sample rate, along with the values it
+        came from. It is trivially copyable, so a set computed ahead of time,
+        e.g. for a preset, can be swapped in at a block boundary without
+        update() running. */
+    struct Coefficients {
+        SampleType thresholddB = 0, ratio = 1, kneeWidthdB = 0, attackTime = 400, releaseTime = 250;
+        SampleType highPassFrequency = 0;
+        double sampleRate = 44100.0;
+        
+        SampleType threshold = 1, thresholdInverse = 1, ratioInverse = 1, thresholdLog2 = 0, gainExponent = 0;
+        SampleType kneeWidth = 0, unityGainLimit = 1, cteAT = 0, cteRL = 0;
+        BiquadCoefficients<double> highPassCoefficients { 1, 0, 0, 0, 0 };
+    };
+    
+    /** The coefficients for the current settings, updated first if needed */
+    Coefficients getCoefficients ();
+    
+    /** Takes over the settings and the coefficients of newCoefficients. If
+        they were computed at another sample rate, only the settings are taken
+        and the coefficients are recomputed before the next block. */
+    void setCoefficients (const Coefficients& newCoefficients);
+    
     //==============================================================================
     /** Initializes the compressor */
     void prepare (const juce::dsp::ProcessSpec& spec);
     
     void reset ();
     
+    /** Moves the compressor to another sample rate without reallocating,
+        e.g. when the oversampling factor changes. The envelope carries over,
+        the lookahead delay and the RMS window restart from silence. The
+        lookahead can only reach maxLookaheadMs at up to the rate passed to
+        prepare(). */
+    void setSampleRate (double newSampleRate);
+    
+    /** Takes over the settings and the state of other, which has to have been
+        prepared with the same spec, e.g. to run a second copy of a path for a
+        crossfade. Doesn't allocate. A plain copy would allocate, and could
+        leave the state off the SIMD aligned start of its storage. */
+    void copyStateFrom (const Compressor& other);
+    
     //==============================================================================
     template <typename ProcessContext>
     void process (const ProcessContext& context) {
@@ -56,28 +224,207 @@ public:
             return;
         }
 
-        for (size_t channel = 0; channel < numChannels; ++channel)
-        {
-            auto* inputSamples  = inputBlock .getChannelPointer (channel);
-            auto* outputSamples = outputBlock.getChannelPointer (channel);
-
-            for (size_t i = 0; i < numSamples; ++i)
-                outputSamples[i] = processSample ((int) channel, inputSamples[i]);
-        }
+        processBlock (inputBlock, outputBlock);
     }
     
+    /** Processes every channel of a block at once. The channels are packed into
+        the lanes of a SIMD register so the envelope state of each channel stays
+        in a register for the whole chunk.
+
+        The VCA dispatches once per block to a kernel specialized for the
+        ratio. With the exact engine the gain stays within 1e-4 dB of
+        ReferenceCompressor in float and 1e-9 dB in double, the bounds
+        Tools/Conformance checks on every path of this function.
+
+        inputGains and outputGains are optional per sample gains, one value per
+        sample of the block, applied before the detector and after the VCA. They
+        let a channel strip fuse its gain stages into the same pass.
+
+        keyBlock, unless empty, feeds the detector instead of the input, e.g. a
+        sidechain bus. It is read in place and may hold any number of channels.
+        One channel is shared by every channel of the input, and with one per
+        input channel each is keyed by its own, unless the detector is linked.
+        Any other
+        number is folded into one detector signal the way the linked detector
+        combines channels, by their mean when linked by the mean and by their
+        maximum otherwise. Only the first maxKeyChannels count. Each key sample
+        stands for 2^keyRateShift input samples, so a key at the base rate can
+        drive an oversampled compressor. The input gains don't apply to it.
+
+        Chunks that are silent, or stay below the threshold at unity gain, skip
+        the VCA (see FastPath). The output is bit identical either way.
+
+        While the threshold ramps, the VCA runs at the new threshold on an
+        envelope scaled by the ratio of the new to the ramping threshold, one
+        scale per frame (see thresholdScale). Every gain curve depends on the
+        envelope over the threshold only, so this is the curve at the ramping
+        threshold, and the kernels stay as they are.
+    */
+    void processBlock (const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                       const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                       const SampleType* inputGains = nullptr,
+                       const SampleType* outputGains = nullptr,
+                       const juce::dsp::AudioBlock<const SampleType>& keyBlock = {},
+                       int keyRateShift = 0);
+    
+    /** Processes one sample of one channel, without the lookahead, the key,
+        the detector filter, the RMS detector and the threshold ramp */
     SampleType processSample (int channel, SampleType inputValue);
 private:
     //==============================================================================
+    /** processBlock() for the linked detector modes. Each channel only costs a
+        pass to build the detector signal and one to apply the gain, the
+        envelope and the VCA run once per frame. */
+    void processLinkedBlock (const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                             const juce::dsp::AudioBlock<SampleType>& outputBlock,
+                             const SampleType* inputGains,
+                             const SampleType* outputGains,
+                             const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                             int keyRateShift);
+    
+    //==============================================================================
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    
     void update ();
     
+    SampleType calculateLimitedCte (SampleType timeMs) const;
+    
+    VCACoefficients<SampleType> getVCACoefficients () const;
+    
+    /** Moves the threshold to newThreshold and restarts the ramp from the
+        threshold the VCA is at */
+    void rampThreshold (SampleType newThreshold);
+    
+    /** Pointers into the storage. They are recomputed from its aligned start
+        whenever they're needed, so the compressor stays copyable. */
+    struct Buffers {
+        SampleType* envelopeState;       // one value per padded channel
+        SampleType* controlGainState;    // one value per padded channel
+        double* filterState;             // two values per filter channel, all
+                                         // the first ones, then the second ones,
+                                         // in the filter state storage
+        SampleType* interleavedInput;    // maxChunkSize frames of SIMD width,
+                                         // the linked detector signal when linked
+        SampleType* interleavedEnvelope; // maxChunkSize frames of SIMD width,
+                                         // the linked envelope and gain when linked
+        SampleType* fullRateGains;       // maxChunkSize frames of SIMD width
+        SampleType* detectorInput;       // maxChunkSize frames of SIMD width,
+                                         // the key or the filtered input
+        SampleType* lookaheadRing;       // ringSize + maxChunkSize frames of SIMD
+                                         // width per group of channels
+        SampleType* rmsSums;             // one value per padded channel
+        SampleType* rmsRing;             // maxRmsWindowSamples frames of SIMD
+                                         // width per group of channels
+        SampleType* linkedRmsRing;       // maxRmsWindowSamples values
+        SampleType* envelopeScales;      // maxChunkSize values
+        SampleType* foldedKey;           // maxChunkSize values
+    };
+    
+    Buffers getBuffers ();
+    
+    /** Writes the envelope scales of the next chunk and sets maxScale to the
+        largest. Returns nullptr when the threshold isn't ramping. */
+    const SampleType* fillEnvelopeScales (const Buffers& buffers, size_t chunkSize, SampleType& maxScale);
+    
+    SampleType* getRingFrames (const Buffers& buffers, size_t firstChannel) const;
+    
+    /** Writes the rectified and filtered detector signal of numDetectorChannels
+        channels of the key, or of the input when there's no key, combined into
+        one by their mean when linked by the mean, by their maximum otherwise */
+    void combineDetectorChunk (const Buffers& buffers, SampleType* detector,
+                               const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                               const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                               size_t numDetectorChannels, size_t startSample, size_t chunkSize,
+                               int keyRateShift);
+    
+    /** Clears the detector filter when it starts, or its input changes */
+    void prepareDetectorFilter (const Buffers& buffers, bool useKey);
+    
+    /** Clears the RMS window when the detector switches to it, or its length changes */
+    void prepareRmsWindow (const Buffers& buffers);
+    
+    void updateRmsWindow ();
+    
+    void updateLatency ();
+    
+    /** What a chunk needs, decided from the peak of its detector input, the
+        envelope and the last gain. While the envelope stays below the
+        threshold, and the gain already is 1, every gain of the chunk is exactly
+        1: the VCA is skipped and the samples are only copied. The envelope
+        still runs, so the state is the same as if the chunk had been fully
+        processed, unless the input and the envelope are all zeros, in which
+        case nothing would change anyway. */
+    enum class FastPath { none, belowThreshold, silence };
+    
+    FastPath getFastPath (SampleType peak, SampleType envelope, SampleType controlGain) const;
+    
+    /** The same for a group of channels, none unless every lane can skip */
+    FastPath getFastPath (SIMDType peaks, SIMDType envelopes, const SampleType* controlGains) const;
+    
+    void measureDeviation (const SampleType* gains, const SampleType* fullRateGains, size_t numValues);
+    
     //==============================================================================
-    juce::dsp::BallisticsFilter<float> envelopeFilter;
+    // Peak rectifier ballistics, modeled after juce::dsp::BallisticsFilter but
+    // with the per channel state kept here so the block kernel can vectorize it.
+    // The storage holds the per channel state (padded to a whole number of SIMD
+    // registers) followed by the scratch buffers used by processBlock().
+    std::vector<SampleType> storage;
+    size_t numPaddedChannels = 0;
+    size_t numFilterChannels = 0;        // padded channels or key channels,
+                                         // whichever are more
+    
+    size_t controlRateInterval = 1;
+    bool isMeasuringDeviation = false;
+    SampleType minDeviationRatio = 1, maxDeviationRatio = 1;
+    
+    SampleType expFactor = static_cast<SampleType> (-0.142), cteAT = 0, cteRL = 0;
+    
+    // Lookahead, the input of every channel goes through a ring in the storage
+    SampleType lookaheadTime = 0;
+    int lookaheadSamples = 0, maxLatencySamples = 0;
+    size_t ringSize = maxChunkSize, ringWritePosition = 0;
+    bool ringHoldsHistory = true;
+    
+    bool isMetering = false;
+    Levels levels;
+    
+    // Detector high-pass. Its coefficients and state are double whatever the
+    // sample type, a float biquad loses the low cutoffs once oversampled.
+    SampleType highPassFrequency = 0;
+    BiquadCoefficients<double> highPassCoefficients { 1, 0, 0, 0, 0 };
+    std::vector<double> filterStateStorage;
+    bool filterHoldsState = false, filterFollowsKey = false;
+    
+    // RMS detector, a running sum over a ring of squares per channel. The
+    // rings live in the storage.
+    DetectorMode detectorMode = DetectorMode::peak;
+    SampleType rmsWindowTime = 10;
+    size_t rmsWindowSamples = 1, maxRmsWindowSamples = 1, rmsPosition = 0;
+    SampleType linkedRmsSum = 0;
+    bool rmsHoldsHistory = false;
+    
+    // Envelope and last gain of the linked detector, shared by every channel
+    DetectorLink detectorLink = DetectorLink::independent;
+    SampleType linkedEnvelopeState = 0, linkedControlGainState = 1;
+    
+    SampleType threshold = 1, thresholdInverse = 1, ratioInverse = 1;
+    
+    SampleType thresholdLog2 = 0, gainExponent = 0;
+    
+    // The threshold ramp, as threshold / the threshold the VCA is at. It ends
+    // on 1, where nothing is scaled.
+    ParameterRamp<SampleType> thresholdScale;
+    double rampDurationSeconds = 0.0;
+    
+    // Knee in octaves, and the envelope below which every gain is exactly 1
+    SampleType kneeWidthdB = 0, kneeWidth = 0, unityGainLimit = 1;
+    
+    GainEngine gainEngine = GainEngine::exact;
     
-    float threshold, thresholdInverse, ratioInverse;
+    bool needsUpdate = true;
     
     double sampleRate = 44100.0;
-    int ratio = 1.0f;
+    SampleType ratio = 1;
     
-    float thresholddB = 0.0f, attackTime = 400.0f, releaseTime = 250.0f;
+    SampleType thresholddB = 0, attackTime = 400, releaseTime = 250;
 };
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+    Created: 16 Oct 2026 10:12:04am
+    Author:  Chris
+ 
+    Polynomial log2 / exp2 approximations for the approximate gain computer.
+    Both are branch free, so loops calling them can be auto-vectorized.
+
+    Error bounds, measured against std::log2 / std::exp2:
+        FastMath::log2 : |error| < 6e-8 octaves plus the rounding of the result,
+                         for any positive normal input
+        FastMath::exp2 : |error| < 2.1e-7 relative in double, < 2.9e-7 in float
+                         where the polynomial itself rounds, for results in
+                         the normal range
+
+    The gain computer evaluates exp2 (e * (log2 (x) - log2 (threshold)))
+    with |e| < 1, both logs approximated. That bounds the gain error to
+    20 * log10 (2) * 2 * 6e-8 + 20 * log10 (1 + 2.1e-7) < 2.6e-6 dB in
+    double, < 3e-6 dB in float, on top of the rounding of the rest of the
+    gain computer. Over 160 dB of input, every ratio and every threshold
+    from -60 to +10 dB, the gain stays within
+        < 2e-5 dB in float, < 2.6e-6 dB in double
+    of the exact engine. These are the bounds the rest of the code refers
+    to; about 1.7e-5 dB and 2.3e-6 dB is the worst measured so far.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace FastMath {
+
+template <typename FloatType>
+struct FloatBits;
+
+template <>
+struct FloatBits<float> {
+    using IntType = int32_t;
+    static constexpr int mantissaBits = 23;
+    static constexpr IntType exponentBias = 127;
+    static constexpr IntType sqrtHalfBits = 0x3f3504f3;     // bit pattern of sqrt (0.5)
+    static constexpr float roundingConstant = 12582912.0f; // 1.5 * 2^23
+};
+
+template <>
+struct FloatBits<double> {
+    using IntType = int64_t;
+    static constexpr int mantissaBits = 52;
+    static constexpr IntType exponentBias = 1023;
+    static constexpr IntType sqrtHalfBits = 0x3fe6a09e667f3bcdLL;
+    static constexpr double roundingConstant = 6755399441055744.0; // 1.5 * 2^52
+};
+
+//==============================================================================
+/** Approximates log2 (x) for positive x. Zero returns a large negative value
+    (about -127 in float) instead of -inf.
+ */
+template <typename FloatType>
+inline FloatType log2 (FloatType x) noexcept {
+    using Bits    = FloatBits<FloatType>;
+    using IntType = typename Bits::IntType;
+
+    IntType bits;
+    std::memcpy (&bits, &x, sizeof (x));
+
+    // Split x into 2^exponent * m with m in [sqrt (0.5), sqrt (2))
+    const auto exponent = (bits - Bits::sqrtHalfBits) >> Bits::mantissaBits;
+    bits -= exponent * (static_cast<IntType> (1) << Bits::mantissaBits);
+
+    FloatType m;
+    std::memcpy (&m, &bits, sizeof (m));
+
+    // log2 (m) = 2 / ln (2) * atanh (s), with |s| < 0.1716
+    const auto s  = (m - static_cast<FloatType> (1.0)) / (m + static_cast<FloatType> (1.0));
+    const auto s2 = s * s;
+
+    return static_cast<FloatType> (exponent)
+         + s * (static_cast<FloatType> (2.8853904219618327)
+         + s2 * (static_cast<FloatType> (0.9615889466941613)
+         + s2 *  static_cast<FloatType> (0.5957596068969726)));
+}
+
+/** Approximates 2^x for |x| < 2^22. Results are clamped to the range of
+    normal numbers, and exp2 (0) is exactly 1.
+ */
+template <typename FloatType>
+inline FloatType exp2 (FloatType x) noexcept {
+    using Bits    = FloatBits<FloatType>;
+    using IntType = typename Bits::IntType;
+
+    // Split x into exponent + f with f in [-0.5, 0.5]. Adding the rounding
+    // constant leaves round (x) in the low mantissa bits, which saves a float
+    // to int conversion the compiler won't vectorize.
+    const auto shifted = x + Bits::roundingConstant;
+    const auto f       = x - (shifted - Bits::roundingConstant);
+
+    IntType exponent, roundingBits;
+    const auto roundingConstant = Bits::roundingConstant;
+    std::memcpy (&exponent, &shifted, sizeof (shifted));
+    std::memcpy (&roundingBits, &roundingConstant, sizeof (roundingConstant));
+    exponent -= roundingBits;
+
+    exponent = (exponent < 1 - Bits::exponentBias) ? 1 - Bits::exponentBias : exponent;
+    exponent = (exponent > Bits::exponentBias)     ? Bits::exponentBias     : exponent;
+
+    const auto bits = (exponent + Bits::exponentBias) * (static_cast<IntType> (1) << Bits::mantissaBits);
+
+    FloatType scale;
+    std::memcpy (&scale, &bits, sizeof (scale));
+
+    return scale * (static_cast<FloatType> (1.0)
+         + f * (static_cast<FloatType> (0.6931471805599453)
+         + f * (static_cast<FloatType> (0.24022349038020388)
+         + f * (static_cast<FloatType> (0.05550381013796484)
+         + f * (static_cast<FloatType> (0.009666368515384533)
+         + f *  static_cast<FloatType> (0.0013381302537301026))))));
+}
+
+} // namespace FastMath
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    Metering.cpp
+    Created: 16 Oct 2026 9:12:05pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "Metering.h"
+
+//==============================================================================
+template <typename SampleType>
+MeterFrame MeterFrame::fromLevels(const typename Compressor<SampleType>::Levels& levels){
+    MeterFrame frame;
+
+    if (levels.numValues == 0)
+        return frame;
+
+    const auto numValues = static_cast<SampleType> (levels.numValues);
+
+    frame.inputPeak       = static_cast<float> (levels.inputPeak);
+    frame.inputRms        = static_cast<float> (std::sqrt (levels.inputSquares / numValues));
+    frame.outputPeak      = static_cast<float> (levels.outputPeak);
+    frame.outputRms       = static_cast<float> (std::sqrt (levels.outputSquares / numValues));
+    frame.gainReductiondB = static_cast<float> (-juce::Decibels::gainToDecibels (levels.minGain));
+
+    return frame;
+}
+
+template MeterFrame MeterFrame::fromLevels<float>  (const Compressor<float>::Levels&);
+template MeterFrame MeterFrame::fromLevels<double> (const Compressor<double>::Levels&);
+
+//==============================================================================
+bool MeterQueue::push(const MeterFrame& frame){
+    // One item never wraps, so it's always in the first block
+    const auto scope = fifo.write (1);
+
+    if (scope.blockSize1 == 0)
+        return false;
+
+    frames[(size_t) scope.startIndex1] = frame;
+    return true;
+}
+
+bool MeterQueue::pop(MeterFrame& frame){
+    const auto scope = fifo.read (1);
+
+    if (scope.blockSize1 == 0)
+        return false;
+
+    frame = frames[(size_t) scope.startIndex1];
+    return true;
+}
+
+bool MeterQueue::popAll(MeterFrame& merged){
+    MeterFrame frame;
+
+    if (! pop (frame))
+        return false;
+
+    merged = frame;
+
+    while (pop (frame))
+    {
+        merged.inputPeak       = juce::jmax (merged.inputPeak,  frame.inputPeak);
+        merged.outputPeak      = juce::jmax (merged.outputPeak, frame.outputPeak);
+        merged.gainReductiondB = juce::jmax (merged.gainReductiondB, frame.gainReductiondB);
+        merged.inputRms        = frame.inputRms;
+        merged.outputRms       = frame.outputRms;
+    }
+
+    return true;
+}
+
+void MeterQueue::clear(){
+    fifo.reset();
+}
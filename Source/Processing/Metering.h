@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    Metering.h
+    Created: 16 Oct 2026 9:12:05pm
+    Author:  Chris
+ 
+    Hands the levels measured on the audio thread to whoever displays or logs
+    them. The audio thread pushes one MeterFrame per block into a fixed size
+    single producer, single consumer queue built on juce::AbstractFifo, so it
+    never locks or allocates. The reader drains it at its own pace.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Compressor.h"
+
+/** The levels of one processed block, over every channel */
+struct MeterFrame {
+    float inputPeak = 0.0f, inputRms = 0.0f;
+    float outputPeak = 0.0f, outputRms = 0.0f;
+    float gainReductiondB = 0.0f;    // the largest in the block, positive
+    
+    template <typename SampleType>
+    static MeterFrame fromLevels (const typename Compressor<SampleType>::Levels& levels);
+};
+
+class MeterQueue {
+public:
+    //==============================================================================
+    static constexpr int capacity = 512;
+    
+    //==============================================================================
+    /** Audio thread only. Returns false and drops the frame when the reader
+        has fallen capacity frames behind. */
+    bool push (const MeterFrame& frame);
+    
+    /** Reader thread only. Takes the oldest frame, returns false when empty. */
+    bool pop (MeterFrame& frame);
+    
+    /** Reader thread only. Empties the queue, returning the peaks and the
+        largest gain reduction of every frame in it, and the RMS of the newest.
+        Returns false when there was nothing to read. */
+    bool popAll (MeterFrame& merged);
+    
+    /** Drops everything queued, only while neither thread uses the queue */
+    void clear ();
+    
+private:
+    //==============================================================================
+    juce::AbstractFifo fifo { capacity };
+    std::array<MeterFrame, capacity> frames;
+};
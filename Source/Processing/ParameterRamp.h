@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.h
+    Created: 16 Oct 2026 7:46:34pm
+    Author:  Chris
+
+    A linear ramp to a target value, like a linear juce::SmoothedValue, but
+    written a block at a time. juce::SmoothedValue::getNextValue() adds the
+    step to a running value and counts down on every call, which chains each
+    sample to the one before it and puts a branch in every iteration. Here
+    every value is computed from one end of the ramp, start + step * n or
+    target - step * (length - n), so the loop filling a block has neither,
+    and vectorizes. That end is the one nearer zero: counted from the other
+    end, the small values would be rounded to the precision of the large
+    one, and a threshold ramp can span 70 dB. The last value of a ramp is
+    exactly the target.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+template <typename SampleType>
+class ParameterRamp {
+public:
+    //==============================================================================
+    /** Sets the length of the ramps and jumps to the target */
+    void reset (double sampleRate, double rampLengthInSeconds) {
+        rampLength = static_cast<int> (std::floor (rampLengthInSeconds * sampleRate));
+        setCurrentAndTargetValue (target);
+    }
+
+    void setCurrentAndTargetValue (SampleType newValue) {
+        start = target = newValue;
+        step = static_cast<SampleType> (0.0);
+        length = position = 0;
+    }
+
+    /** Starts a ramp from the current value, or jumps when the ramps are 0 long */
+    void setTargetValue (SampleType newValue) {
+        if (newValue == target)
+            return;
+
+        if (rampLength <= 0)
+        {
+            setCurrentAndTargetValue (newValue);
+            return;
+        }
+
+        start    = getCurrentValue();
+        target   = newValue;
+        step     = (target - start) / static_cast<SampleType> (rampLength);
+        length   = rampLength;
+        position = 0;
+    }
+
+    SampleType getCurrentValue () const { return position < length ? getValue (position) : target; }
+    SampleType getTargetValue () const { return target; }
+    bool isSmoothing () const { return position < length; }
+
+    //==============================================================================
+    /** Writes the next numSamples values to destination */
+    void fill (SampleType* destination, size_t numSamples) {
+        const auto numRamped = static_cast<size_t> (juce::jmin (static_cast<int> (numSamples), length - position));
+
+        if (isFromStart())
+        {
+            const auto first = static_cast<SampleType> (position + 1);
+
+            for (size_t i = 0; i < numRamped; ++i)
+                destination[i] = start + step * (first + static_cast<SampleType> (i));
+        }
+        else
+        {
+            const auto first = static_cast<SampleType> (length - position - 1);
+
+            for (size_t i = 0; i < numRamped; ++i)
+                destination[i] = target - step * (first - static_cast<SampleType> (i));
+        }
+
+        // The ramp ends on the target, whatever the rounding of the step
+        if (numRamped > 0 && position + static_cast<int> (numRamped) == length)
+            destination[numRamped - 1] = target;
+
+        std::fill (destination + numRamped, destination + numSamples, target);
+
+        skip (static_cast<int> (numRamped));
+    }
+
+    /** Moves on by numSamples, as if they had been filled */
+    void skip (int numSamples) {
+        position = juce::jmin (length, position + numSamples);
+
+        if (position == length)
+            setCurrentAndTargetValue (target);
+    }
+
+private:
+    //==============================================================================
+    bool isFromStart () const { return std::abs (start) <= std::abs (target); }
+
+    SampleType getValue (int n) const {
+        return isFromStart() ? start + step * static_cast<SampleType> (n)
+                             : target - step * static_cast<SampleType> (length - n);
+    }
+
+    SampleType start = 0, target = 0, step = 0;
+    int length = 0, position = 0, rampLength = 0;
+};
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    ReferenceCompressor.cpp
+    Created: 16 Oct 2026 7:55:16pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "ReferenceCompressor.h"
+
+template <typename SampleType>
+ReferenceCompressor<SampleType>::ReferenceCompressor(){
+    update();
+}
+
+//==============================================================================
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::setThreshold(SampleType newThreshold){
+    thresholddB = newThreshold;
+    update();
+}
+
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::setRatio(SampleType newRatio){
+    ratio = newRatio;
+    update();
+}
+
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::setAttack(SampleType newAttack){
+    attackTime = newAttack;
+    update();
+}
+
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::setRelease(SampleType newRelease){
+    releaseTime = newRelease;
+    update();
+}
+
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::setKneeWidth(SampleType newKneeWidth){
+    kneeWidthdB = newKneeWidth;
+    update();
+}
+
+//==============================================================================
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::prepare(double newSampleRate, int numChannels){
+    jassert (newSampleRate > 0);
+    jassert (numChannels > 0);
+
+    sampleRate = newSampleRate;
+    envelopeState.assign (static_cast<size_t> (numChannels), static_cast<SampleType> (0.0));
+
+    update();
+}
+
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::reset(){
+    std::fill (envelopeState.begin(), envelopeState.end(), static_cast<SampleType> (0.0));
+}
+
+//==============================================================================
+template <typename SampleType>
+SampleType ReferenceCompressor<SampleType>::processSample(int channel, SampleType inputValue){
+    return getGain (channel, inputValue) * inputValue;
+}
+
+template <typename SampleType>
+SampleType ReferenceCompressor<SampleType>::getGain(int channel, SampleType keyValue){
+    // Ballistics filter with peak rectifier
+    auto& state = envelopeState[static_cast<size_t> (channel)];
+    const auto input = std::abs (keyValue);
+    const auto cte   = input > state ? cteAT : cteRL;
+    const auto env   = input + cte * (state - input);
+    state = env;
+
+    // VCA
+    SampleType gain;
+
+    if (kneeWidth > static_cast<SampleType> (0.0))
+    {
+        // exp2 of the overshoot in octaves times the exponent, bent
+        // quadratically across the knee
+        const auto overshoot = std::log2 (env * thresholdInverse);
+        const auto halfWidth = kneeWidth * static_cast<SampleType> (0.5);
+        const auto inKnee    = juce::jlimit (static_cast<SampleType> (0.0), kneeWidth, overshoot + halfWidth);
+        const auto aboveKnee = juce::jmax (static_cast<SampleType> (0.0), overshoot - halfWidth);
+
+        gain = std::exp2 ((inKnee * inKnee / (static_cast<SampleType> (2.0) * kneeWidth) + aboveKnee) * exponent);
+    }
+    else
+    {
+        gain = env < threshold ? static_cast<SampleType> (1.0)
+                               : std::pow (env * thresholdInverse, exponent);
+    }
+
+    return gain;
+}
+
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::process(SampleType* const* channels, int numChannels, int numSamples){
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < numSamples; ++i)
+            channels[channel][i] = processSample (channel, channels[channel][i]);
+}
+
+//==============================================================================
+template <typename SampleType>
+void ReferenceCompressor<SampleType>::update(){
+    threshold        = juce::Decibels::decibelsToGain (thresholddB, static_cast<SampleType> (-200.0));
+    thresholdInverse = static_cast<SampleType> (1.0) / threshold;
+    exponent         = static_cast<SampleType> (1.0) / ratio - static_cast<SampleType> (1.0);
+
+    // dB to octaves of the envelope
+    kneeWidth = kneeWidthdB > static_cast<SampleType> (0.0) ? kneeWidthdB / static_cast<SampleType> (20.0 * std::log10 (2.0))
+                                                            : static_cast<SampleType> (0.0);
+
+    expFactor = static_cast<SampleType> (-2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate);
+    cteAT = getCte (attackTime);
+    cteRL = getCte (releaseTime);
+}
+
+template <typename SampleType>
+SampleType ReferenceCompressor<SampleType>::getCte(SampleType timeMs) const{
+    return timeMs < static_cast<SampleType> (1.0e-3) ? static_cast<SampleType> (0.0)
+                                                     : static_cast<SampleType> (std::exp (expFactor / timeMs));
+}
+
+//==============================================================================
+template class ReferenceCompressor<float>;
+template class ReferenceCompressor<double>;
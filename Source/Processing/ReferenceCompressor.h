@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    ReferenceCompressor.h
+    Created: 16 Oct 2026 7:55:16pm
+    Author:  Chris
+
+    The compressor as it was before any of the block processing, one sample
+    of one channel at a time: the peak ballistics, then std::pow (or the soft
+    knee in std::log2 and std::exp2) on every sample. Nothing is vectorized,
+    approximated or skipped, so it is slow on purpose.
+
+    It shares no code with Compressor, so the two can't drift together. The
+    conformance tool (Tools/Conformance) checks every optimized path of
+    Compressor against it, and checks it, in float with a hard knee, bit
+    for bit against a copy of the original juce::dsp::BallisticsFilter and
+    std::pow code. Don't optimize it, a faster reference proves nothing.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+template <typename SampleType>
+class ReferenceCompressor {
+public:
+    //==============================================================================
+    ReferenceCompressor();
+
+    //==============================================================================
+    // Unlike Compressor, every setter recomputes the coefficients right away.
+
+    /** Sets the threshold of the compressor in decibels */
+    void setThreshold (SampleType newThreshold);
+
+    /** Sets the ratio of the compressor **/
+    void setRatio (SampleType newRatio);
+
+    /** Sets the attack time of the compressor in microseconds **/
+    void setAttack (SampleType newAttack);
+
+    /** Sets the release time of the compressor in milliseconds **/
+    void setRelease (SampleType newRelease);
+
+    /** Sets the width of the knee in decibels, centered on the threshold. 0
+        is a hard knee. **/
+    void setKneeWidth (SampleType newKneeWidth);
+
+    //==============================================================================
+    void prepare (double newSampleRate, int numChannels);
+
+    void reset ();
+
+    SampleType processSample (int channel, SampleType inputValue);
+
+    /** Runs the detector of channel on keyValue and returns the gain of the
+        VCA, without applying it. processSample() is the input times
+        getGain (channel, inputValue). */
+    SampleType getGain (int channel, SampleType keyValue);
+
+    /** Processes numSamples of every channel in place, one channel after the other */
+    void process (SampleType* const* channels, int numChannels, int numSamples);
+
+private:
+    //==============================================================================
+    void update ();
+
+    /** The one pole coefficient of juce::dsp::BallisticsFilter */
+    SampleType getCte (SampleType timeMs) const;
+
+    std::vector<SampleType> envelopeState;
+
+    SampleType threshold = 1, thresholdInverse = 1, exponent = 0, kneeWidth = 0;
+    SampleType expFactor = 0, cteAT = 0, cteRL = 0;
+
+    double sampleRate = 44100.0;
+
+    SampleType thresholddB = 0, ratio = 1, kneeWidthdB = 0, attackTime = 400, releaseTime = 250;
+};
@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    StreamEngine.cpp
+    Created: 16 Oct 2026 7:39:27pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "StreamEngine.h"
+
+/** Sleeps until process() hands it a round, then works until no stream is left */
+template <typename SampleType>
+class StreamEngine<SampleType>::Worker : public juce::Thread {
+public:
+    Worker (StreamEngine& owner, int index)
+        : juce::Thread ("StreamEngine worker " + juce::String (index)), engine (owner), workerIndex (index) {}
+
+    void run () override {
+        juce::ScopedNoDenormals noDenormals;
+
+        while (! threadShouldExit())
+        {
+            start.wait (-1);
+
+            if (threadShouldExit())
+                return;
+
+            engine.work (workerIndex);
+
+            if (--engine.numRunningWorkers == 0)
+                engine.workersFinished.signal();
+        }
+    }
+
+    juce::WaitableEvent start;
+
+private:
+    StreamEngine& engine;
+    const int workerIndex;
+};
+
+//==============================================================================
+template <typename SampleType>
+StreamEngine<SampleType>::StreamEngine(int numThreads){
+    numThreads = juce::jmax (1, numThreads);
+    queues = std::make_unique<WorkQueue[]> (static_cast<size_t> (numThreads));
+
+    // The thread calling process() is worker 0
+    for (int i = 1; i < numThreads; ++i)
+    {
+        workers.push_back (std::make_unique<Worker> (*this, i));
+        workers.back()->startThread (juce::Thread::Priority::high);
+    }
+}
+
+template <typename SampleType>
+StreamEngine<SampleType>::~StreamEngine(){
+    for (auto& worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->start.signal();
+    }
+
+    for (auto& worker : workers)
+        worker->stopThread (-1);
+}
+
+//==============================================================================
+template <typename SampleType>
+void StreamEngine<SampleType>::prepare(int newNumStreams, const juce::dsp::ProcessSpec& spec){
+    jassert (newNumStreams >= 0);
+    jassert (spec.maximumBlockSize > 0);
+
+    sampleRate   = spec.sampleRate;
+    maxBlockSize = spec.maximumBlockSize;
+
+    numStreams = juce::jmax (0, newNumStreams);
+    streams = std::make_unique<Stream[]> (static_cast<size_t> (numStreams));
+
+    for (int i = 0; i < numStreams; ++i)
+    {
+        auto& stream = streams[(size_t) i];
+        stream.compressor.setRampDurationSeconds (rampDurationSeconds);
+        stream.compressor.prepare (spec);
+        stream.inputGain .setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+        stream.outputGain.setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+    }
+
+    workerBuffers = std::make_unique<WorkerBuffers[]> (static_cast<size_t> (getNumThreads()));
+
+    for (int i = 0; i < getNumThreads(); ++i)
+    {
+        workerBuffers[(size_t) i].inputGainRamp .assign (maxBlockSize, static_cast<SampleType> (1.0));
+        workerBuffers[(size_t) i].outputGainRamp.assign (maxBlockSize, static_cast<SampleType> (1.0));
+    }
+
+    reset();
+}
+
+template <typename SampleType>
+void StreamEngine<SampleType>::reset(){
+    for (int i = 0; i < numStreams; ++i)
+    {
+        auto& stream = streams[(size_t) i];
+        stream.compressor.reset();
+        stream.inputGain .reset (sampleRate, rampDurationSeconds);
+        stream.outputGain.reset (sampleRate, rampDurationSeconds);
+    }
+}
+
+template <typename SampleType>
+Compressor<SampleType>& StreamEngine<SampleType>::getCompressor(int stream){
+    jassert (juce::isPositiveAndBelow (stream, numStreams));
+    return streams[(size_t) stream].compressor;
+}
+
+template <typename SampleType>
+void StreamEngine<SampleType>::setInputGainDecibels(int stream, SampleType newGainDecibels){
+    jassert (juce::isPositiveAndBelow (stream, numStreams));
+    streams[(size_t) stream].inputGain.setTargetValue (juce::Decibels::decibelsToGain (newGainDecibels));
+}
+
+template <typename SampleType>
+void StreamEngine<SampleType>::setOutputGainDecibels(int stream, SampleType newGainDecibels){
+    jassert (juce::isPositiveAndBelow (stream, numStreams));
+    streams[(size_t) stream].outputGain.setTargetValue (juce::Decibels::decibelsToGain (newGainDecibels));
+}
+
+template <typename SampleType>
+void StreamEngine<SampleType>::setRampDurationSeconds(double newDurationSeconds){
+    if (juce::approximatelyEqual (rampDurationSeconds, newDurationSeconds))
+        return;
+
+    rampDurationSeconds = newDurationSeconds;
+
+    for (int i = 0; i < numStreams; ++i)
+        streams[(size_t) i].compressor.setRampDurationSeconds (rampDurationSeconds);
+
+    reset();
+}
+
+//==============================================================================
+template <typename SampleType>
+void StreamEngine<SampleType>::process(const juce::dsp::AudioBlock<SampleType>* blocks, int numBlocks){
+    juce::ScopedNoDenormals noDenormals;
+
+    numBlocks = juce::jlimit (0, numStreams, numBlocks);
+
+    if (numBlocks == 0)
+        return;
+
+    for (int i = 0; i < numBlocks; ++i)
+        streams[(size_t) i].block = blocks[i];
+
+    // Contiguous ranges, so each worker starts on streams next to each other
+    numActiveWorkers = juce::jmin (getNumThreads(), numBlocks);
+
+    for (int i = 0; i < numActiveWorkers; ++i)
+    {
+        const auto begin = static_cast<juce::uint32> (i * numBlocks / numActiveWorkers);
+        const auto end   = static_cast<juce::uint32> ((i + 1) * numBlocks / numActiveWorkers);
+        queues[(size_t) i].range.store (packRange (begin, end), std::memory_order_relaxed);
+    }
+
+    numRunningWorkers = numActiveWorkers - 1;
+
+    for (int i = 1; i < numActiveWorkers; ++i)
+        workers[(size_t) i - 1]->start.signal();
+
+    work (0);
+
+    // The other workers may still be finishing the last stream they took
+    if (numActiveWorkers > 1)
+        workersFinished.wait (-1);
+}
+
+template <typename SampleType>
+void StreamEngine<SampleType>::work(int workerIndex){
+    for (;;)
+    {
+        auto stream = popStream (queues[(size_t) workerIndex]);
+
+        if (stream < 0)
+            stream = stealStreams (workerIndex);
+
+        if (stream < 0)
+            return;
+
+        auto& slot = streams[(size_t) stream];
+
+        if (slot.block.getNumSamples() > 0 && slot.block.getNumChannels() > 0)
+            processStream (slot, workerBuffers[(size_t) workerIndex]);
+    }
+}
+
+template <typename SampleType>
+void StreamEngine<SampleType>::processStream(Stream& stream, WorkerBuffers& buffers){
+    const auto numSamples = stream.block.getNumSamples();
+
+    // Like ChannelStrip::fillGainRamp(), nullptr while a gain is steady at unity
+    const auto fillGainRamp = [] (ParameterRamp<SampleType>& gain, std::vector<SampleType>& buffer, size_t numValues) -> const SampleType*
+    {
+        if (! gain.isSmoothing() && gain.getTargetValue() == static_cast<SampleType> (1.0))
+            return nullptr;
+
+        gain.fill (buffer.data(), numValues);
+        return buffer.data();
+    };
+
+    for (size_t startSample = 0; startSample < numSamples; startSample += maxBlockSize)
+    {
+        const auto blockSize = juce::jmin (maxBlockSize, numSamples - startSample);
+        const auto block     = stream.block.getSubBlock (startSample, blockSize);
+
+        stream.compressor.processBlock (block, block,
+                                        fillGainRamp (stream.inputGain,  buffers.inputGainRamp,  blockSize),
+                                        fillGainRamp (stream.outputGain, buffers.outputGainRamp, blockSize));
+    }
+}
+
+template <typename SampleType>
+int StreamEngine<SampleType>::popStream(WorkQueue& queue){
+    auto range = queue.range.load (std::memory_order_acquire);
+
+    for (;;)
+    {
+        const auto begin = getBegin (range), end = getEnd (range);
+
+        if (begin >= end)
+            return -1;
+
+        if (queue.range.compare_exchange_weak (range, packRange (begin + 1, end), std::memory_order_acq_rel))
+            return static_cast<int> (begin);
+    }
+}
+
+template <typename SampleType>
+int StreamEngine<SampleType>::stealStreams(int workerIndex){
+    for (int i = 1; i < numActiveWorkers; ++i)
+    {
+        auto& victim = queues[(size_t) ((workerIndex + i) % numActiveWorkers)];
+        auto range = victim.range.load (std::memory_order_acquire);
+
+        for (;;)
+        {
+            const auto begin = getBegin (range), end = getEnd (range);
+
+            if (begin >= end)
+                break;
+
+            const auto newEnd = end - (end - begin + 1) / 2;
+
+            if (victim.range.compare_exchange_weak (range, packRange (begin, newEnd), std::memory_order_acq_rel))
+            {
+                // Nobody steals from an empty queue, so a plain store is enough
+                queues[(size_t) workerIndex].range.store (packRange (newEnd + 1, end), std::memory_order_release);
+                return static_cast<int> (newEnd);
+            }
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+template class StreamEngine<float>;
+template class StreamEngine<double>;
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    StreamEngine.h
+    Created: 16 Oct 2026 7:39:27pm
+    Author:  Chris
+
+    Many independent compressors, one per stream, processed in parallel,
+    e.g. one per incoming broadcast stream. No host and no parameter tree,
+    every stream is configured directly.
+
+    A stream only keeps what has to outlive a block: its compressor and the
+    ramps of its input and output gains. No oversampling, bypass fade or dry
+    delay, ChannelStrip is there for those. The buffers the ramps are
+    written to belong to the workers. A slot is sizeof (Stream), a few
+    hundred bytes, plus the compressor's storage, see Compressor::prepare(),
+    which is mostly its lookahead ring and RMS window: about 60 KB for a
+    stereo float stream at 48 kHz with 4 lane registers.
+
+    Each stream lives in its own cache line aligned slot, so workers on
+    neighbouring streams never share a line. process() spreads the streams
+    over the workers as contiguous ranges, and a worker that runs out steals
+    half of what is left in another's range. A range is a single atomic
+    word that owner and thieves both update with a compare and swap, so
+    handing out the streams takes no lock. Waking the workers and waiting
+    for them does: both go through a juce::WaitableEvent, a mutex and a
+    condition variable, once per worker per call to process().
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Compressor.h"
+
+template <typename SampleType>
+class StreamEngine {
+public:
+    //==============================================================================
+    /** numThreads workers, counting the thread that calls process() */
+    explicit StreamEngine (int numThreads = juce::SystemStats::getNumCpus());
+    ~StreamEngine ();
+
+    //==============================================================================
+    /** Allocates numStreams compressors and prepares each for spec. Not
+        realtime safe. */
+    void prepare (int numStreams, const juce::dsp::ProcessSpec& spec);
+
+    void reset ();
+
+    int getNumStreams () const { return numStreams; }
+    int getNumThreads () const { return static_cast<int> (workers.size()) + 1; }
+
+    /** The compressor of one stream. Its parameters may be changed between
+        calls to process(), from the thread that calls it. */
+    Compressor<SampleType>& getCompressor (int stream);
+
+    /** Set the gains applied before and after the compressor of one stream
+        in decibels, like ChannelStrip's, from the thread that calls
+        process(). They ramp over the time given to setRampDurationSeconds(). */
+    void setInputGainDecibels  (int stream, SampleType newGainDecibels);
+    void setOutputGainDecibels (int stream, SampleType newGainDecibels);
+
+    /** How long the gains and the threshold of every stream take to reach a
+        new value */
+    void setRampDurationSeconds (double newDurationSeconds);
+
+    //==============================================================================
+    /** Processes blocks[i] in place with the compressor of stream i, for every
+        stream below numBlocks, and returns once all of them are done. Empty
+        blocks are skipped. Doesn't allocate. The streams are handed out
+        without locks, but waking the workers and waiting for the last one
+        goes through WaitableEvents, which lock. */
+    void process (const juce::dsp::AudioBlock<SampleType>* blocks, int numBlocks);
+
+    static constexpr size_t cacheLineSize = 64;
+
+private:
+    //==============================================================================
+    struct alignas (cacheLineSize) Stream {
+        Compressor<SampleType> compressor;
+        ParameterRamp<SampleType> inputGain, outputGain;
+        juce::dsp::AudioBlock<SampleType> block;
+    };
+
+    /** What a worker writes the gain ramps of its current stream to */
+    struct alignas (cacheLineSize) WorkerBuffers {
+        std::vector<SampleType> inputGainRamp, outputGainRamp;
+    };
+
+    /** The streams left to one worker, [begin, end) packed in one word */
+    struct alignas (cacheLineSize) WorkQueue {
+        std::atomic<juce::uint64> range { 0 };
+    };
+
+    class Worker;
+
+    /** Runs streams until every queue is empty */
+    void work (int workerIndex);
+
+    /** Runs one stream's block through its gains and compressor, in pieces
+        the worker's buffers can hold */
+    void processStream (Stream& stream, WorkerBuffers& buffers);
+
+    /** Takes the first stream of a queue, or returns -1 */
+    int popStream (WorkQueue& queue);
+
+    /** Moves the back half of another worker's queue to the empty queue of
+        workerIndex and returns its first stream, or returns -1 */
+    int stealStreams (int workerIndex);
+
+    static juce::uint64 packRange (juce::uint32 begin, juce::uint32 end) { return (static_cast<juce::uint64> (end) << 32) | begin; }
+    static juce::uint32 getBegin (juce::uint64 range) { return static_cast<juce::uint32> (range); }
+    static juce::uint32 getEnd (juce::uint64 range)   { return static_cast<juce::uint32> (range >> 32); }
+
+    //==============================================================================
+    std::unique_ptr<Stream[]> streams;
+    int numStreams = 0;
+
+    std::unique_ptr<WorkerBuffers[]> workerBuffers;
+    double sampleRate = 44100.0, rampDurationSeconds = 0.0;
+    size_t maxBlockSize = 0;
+
+    std::unique_ptr<WorkQueue[]> queues;
+    int numActiveWorkers = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<int> numRunningWorkers { 0 };
+    juce::WaitableEvent workersFinished;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamEngine)
+};
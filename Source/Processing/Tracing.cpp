@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    Tracing.cpp
+    Created: 16 Oct 2026 7:42:56pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "Tracing.h"
+
+#if COMPRESSOR_ENABLE_TRACING
+
+namespace Tracing {
+
+namespace {
+
+struct Event {
+    const char* name;
+    juce::int64 start, end;
+    bool isInstant;
+};
+
+/** Single producer, its thread. The reader copies what it can and drops
+    whatever was overwritten meanwhile. */
+struct Ring {
+    std::unique_ptr<Event[]> events;
+    std::atomic<juce::uint64> numWritten { 0 };
+};
+
+struct State {
+    juce::CriticalSection prepareLock;
+    std::atomic<bool> isPrepared { false };
+    int numUsers = 0;
+
+    std::unique_ptr<Ring[]> rings;
+    int numRings = 0;
+    size_t capacity = 0;
+    std::atomic<int> numClaimed { 0 };
+
+    std::atomic<juce::int64> deadlineTicks { 0 }, worstTicks { 0 };
+    std::atomic<juce::uint64> numBlocks { 0 }, numOverDeadline { 0 };
+    std::array<std::atomic<juce::uint64>, BlockHistogram::numBins + 1> counts {};
+};
+
+State& getState(){
+    static State state;
+    return state;
+}
+
+// Index of this thread's ring, numRings when every ring was taken
+thread_local int ringIndex = -1;
+
+Ring* getRing(){
+    auto& state = getState();
+
+    if (! state.isPrepared.load (std::memory_order_acquire))
+        return nullptr;
+
+    if (ringIndex < 0)
+        ringIndex = juce::jmin (state.numClaimed.fetch_add (1), state.numRings);
+
+    return ringIndex < state.numRings ? &state.rings[(size_t) ringIndex] : nullptr;
+}
+
+void push(const char* name, juce::int64 start, juce::int64 end, bool isInstant){
+    if (auto* ring = getRing())
+    {
+        const auto index = ring->numWritten.load (std::memory_order_relaxed);
+        ring->events[index % getState().capacity] = { name, start, end, isInstant };
+        ring->numWritten.store (index + 1, std::memory_order_release);
+    }
+}
+
+} // namespace
+
+//==============================================================================
+void prepare(int maxThreads, int eventsPerThread){
+    auto& state = getState();
+    const juce::ScopedLock sl (state.prepareLock);
+
+    ++state.numUsers;
+
+    if (state.isPrepared)
+        return;
+
+    state.numRings = juce::jmax (1, maxThreads);
+    state.capacity = static_cast<size_t> (juce::jmax (1, eventsPerThread));
+    state.rings    = std::make_unique<Ring[]> ((size_t) state.numRings);
+
+    for (int i = 0; i < state.numRings; ++i)
+        state.rings[(size_t) i].events = std::make_unique<Event[]> (state.capacity);
+
+    state.isPrepared.store (true, std::memory_order_release);
+}
+
+bool release(){
+    auto& state = getState();
+    const juce::ScopedLock sl (state.prepareLock);
+
+    jassert (state.numUsers > 0);
+    state.numUsers = juce::jmax (0, state.numUsers - 1);
+    return state.numUsers == 0;
+}
+
+void setDeadline(int maximumBlockSize, double sampleRate){
+    if (sampleRate > 0.0)
+        getState().deadlineTicks = juce::Time::secondsToHighResolutionTicks (maximumBlockSize / sampleRate);
+}
+
+void recordStage(const char* name, juce::int64 start, juce::int64 end){
+    push (name, start, end, false);
+}
+
+void recordInstant(const char* name){
+    const auto now = juce::Time::getHighResolutionTicks();
+    push (name, now, now, true);
+}
+
+void recordBlock(juce::int64 start, juce::int64 end){
+    push ("processBlock", start, end, false);
+
+    auto& state = getState();
+    const auto duration = end - start;
+    const auto deadline = state.deadlineTicks.load (std::memory_order_relaxed);
+
+    if (deadline > 0)
+    {
+        const auto fraction = static_cast<double> (duration) / static_cast<double> (deadline);
+        const auto bin = juce::jmin (BlockHistogram::numBins, static_cast<int> (fraction / BlockHistogram::binWidth));
+        state.counts[(size_t) bin].fetch_add (1, std::memory_order_relaxed);
+
+        if (duration > deadline)
+            state.numOverDeadline.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    state.numBlocks.fetch_add (1, std::memory_order_relaxed);
+
+    auto worst = state.worstTicks.load (std::memory_order_relaxed);
+
+    while (duration > worst && ! state.worstTicks.compare_exchange_weak (worst, duration, std::memory_order_relaxed)) {}
+}
+
+//==============================================================================
+BlockHistogram getBlockHistogram(){
+    auto& state = getState();
+    BlockHistogram histogram;
+
+    histogram.deadlineSeconds = juce::Time::highResolutionTicksToSeconds (state.deadlineTicks);
+    histogram.worstSeconds    = juce::Time::highResolutionTicksToSeconds (state.worstTicks);
+    histogram.numBlocks       = state.numBlocks;
+    histogram.numOverDeadline = state.numOverDeadline;
+
+    for (size_t i = 0; i < histogram.counts.size(); ++i)
+        histogram.counts[i] = state.counts[i];
+
+    return histogram;
+}
+
+void writeChromeTrace(juce::OutputStream& stream){
+    auto& state = getState();
+
+    // Copies of what each ring holds, tagged with the ring as the thread id
+    std::vector<std::pair<int, Event>> events;
+
+    if (state.isPrepared.load (std::memory_order_acquire))
+    {
+        for (int i = 0; i < state.numRings; ++i)
+        {
+            auto& ring = state.rings[(size_t) i];
+            const auto numWritten = ring.numWritten.load (std::memory_order_acquire);
+            const auto first = numWritten > state.capacity ? numWritten - state.capacity : 0;
+            const auto numBefore = events.size();
+
+            for (auto index = first; index < numWritten; ++index)
+                events.emplace_back (i, ring.events[index % state.capacity]);
+
+            // Whatever the thread wrote meanwhile may have replaced the oldest
+            const auto numWrittenAfter = ring.numWritten.load (std::memory_order_acquire);
+            const auto firstIntact = numWrittenAfter > state.capacity ? numWrittenAfter - state.capacity : 0;
+            const auto numTorn = static_cast<size_t> (juce::jmin (numWritten, juce::jmax (first, firstIntact)) - first);
+
+            events.erase (events.begin() + (std::ptrdiff_t) numBefore, events.begin() + (std::ptrdiff_t) (numBefore + numTorn));
+        }
+    }
+
+    auto origin = std::numeric_limits<juce::int64>::max();
+
+    for (const auto& event : events)
+        origin = juce::jmin (origin, event.second.start);
+
+    auto toMicroseconds = [] (juce::int64 ticks) { return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6; };
+
+    stream << "{\"traceEvents\":[";
+
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const auto& [thread, event] = events[i];
+
+        stream << (i > 0 ? ",\n" : "\n")
+               << "{\"name\":" << juce::JSON::toString (juce::var (event.name))
+               << ",\"cat\":\"compressor\",\"pid\":1,\"tid\":" << thread
+               << ",\"ts\":" << juce::String (toMicroseconds (event.start - origin), 3);
+
+        if (event.isInstant)
+            stream << ",\"ph\":\"i\",\"s\":\"t\"}";
+        else
+            stream << ",\"ph\":\"X\",\"dur\":" << juce::String (toMicroseconds (event.end - event.start), 3) << "}";
+    }
+
+    const auto histogram = getBlockHistogram();
+
+    stream << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{"
+           << "\"blockDeadlineMs\":" << juce::String (histogram.deadlineSeconds * 1000.0, 4)
+           << ",\"worstBlockMs\":" << juce::String (histogram.worstSeconds * 1000.0, 4)
+           << ",\"blocks\":" << juce::String ((juce::int64) histogram.numBlocks)
+           << ",\"blocksOverDeadline\":" << juce::String ((juce::int64) histogram.numOverDeadline)
+           << ",\"histogramBinPercent\":" << juce::String (BlockHistogram::binWidth * 100.0)
+           << ",\"blockLatencyHistogram\":[";
+
+    for (size_t i = 0; i < histogram.counts.size(); ++i)
+        stream << (i > 0 ? "," : "") << juce::String ((juce::int64) histogram.counts[i]);
+
+    stream << "]}}\n";
+}
+
+void clear(){
+    auto& state = getState();
+
+    if (state.isPrepared.load (std::memory_order_acquire))
+        for (int i = 0; i < state.numRings; ++i)
+            state.rings[(size_t) i].numWritten = 0;
+
+    state.worstTicks      = 0;
+    state.numBlocks       = 0;
+    state.numOverDeadline = 0;
+
+    for (auto& count : state.counts)
+        count = 0;
+}
+
+} // namespace Tracing
+
+#endif
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    Tracing.h
+    Created: 16 Oct 2026 7:42:56pm
+    Author:  Chris
+
+    Timestamps of the stages of the audio path, for finding out which one
+    used up the time budget when a session glitches. Compiled out unless
+    COMPRESSOR_ENABLE_TRACING is defined to 1 (in the Projucer's
+    preprocessor definitions), the macros below are then empty.
+
+    Every thread that records gets its own ring of events, allocated by
+    prepare() before the audio starts. Recording is a few stores into that
+    ring, without locks or allocation. When a ring is full the oldest
+    events are overwritten, so the trace always holds the most recent ones.
+    Blocks are also counted into a latency histogram, relative to the
+    deadline of a full block (maximumBlockSize samples at the sample rate).
+
+    writeChromeTrace() exports the rings as Chrome trace JSON, which
+    chrome://tracing and ui.perfetto.dev both open, with the histogram in
+    its metadata.
+
+    There is one trace per process, not per plugin instance: the instances
+    of a session share the host's audio threads, and one timeline of all of
+    them shows which one held a thread up. Each instance counts itself in
+    with prepare() and out with release(), and only the last one out
+    exports and clears the trace, so stopping one instance doesn't wipe
+    what the others recorded.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+#ifndef COMPRESSOR_ENABLE_TRACING
+ #define COMPRESSOR_ENABLE_TRACING 0
+#endif
+
+#if COMPRESSOR_ENABLE_TRACING
+
+namespace Tracing {
+
+//==============================================================================
+/** Counts a user of the trace in, pair it with release(). The first call
+    allocates the rings, maxThreads of them with eventsPerThread events
+    each, later ones only count, so call it early from a non-realtime
+    thread, e.g. in prepareToPlay(). Events recorded before it are dropped. */
+void prepare (int maxThreads = 16, int eventsPerThread = 1 << 15);
+
+/** Counts a user out. Returns true for the last one, which should export
+    the trace and clear() it. The rings stay allocated. */
+bool release ();
+
+/** Sets the deadline blocks are measured against */
+void setDeadline (int maximumBlockSize, double sampleRate);
+
+/** A stage that ran from start to end, in high resolution ticks. name must
+    be a string literal, or live as long as the trace. */
+void recordStage (const char* name, juce::int64 start, juce::int64 end);
+
+/** A single point in time, e.g. a parameter change */
+void recordInstant (const char* name);
+
+/** A whole block, recorded as a stage and counted into the histogram */
+void recordBlock (juce::int64 start, juce::int64 end);
+
+//==============================================================================
+struct BlockHistogram {
+    static constexpr int numBins = 40;             // 5 % of the deadline each
+    static constexpr double binWidth = 0.05;
+
+    double deadlineSeconds = 0.0, worstSeconds = 0.0;
+    juce::uint64 numBlocks = 0, numOverDeadline = 0;
+    std::array<juce::uint64, numBins + 1> counts {};    // the last one is >= 200 %
+};
+
+BlockHistogram getBlockHistogram ();
+
+/** Writes every event still in the rings as Chrome trace JSON. Safe while
+    recording, events overwritten during the copy are left out. */
+void writeChromeTrace (juce::OutputStream& stream);
+
+/** Drops every event and the histogram */
+void clear ();
+
+//==============================================================================
+/** Records a stage from construction to destruction */
+class ScopedStage {
+public:
+    explicit ScopedStage (const char* stageName)
+        : name (stageName), start (juce::Time::getHighResolutionTicks()) {}
+
+    ~ScopedStage () { recordStage (name, start, juce::Time::getHighResolutionTicks()); }
+
+private:
+    const char* name;
+    juce::int64 start;
+};
+
+/** Records a block from construction to destruction */
+class ScopedBlock {
+public:
+    ScopedBlock () : start (juce::Time::getHighResolutionTicks()) {}
+    ~ScopedBlock () { recordBlock (start, juce::Time::getHighResolutionTicks()); }
+
+private:
+    juce::int64 start;
+};
+
+} // namespace Tracing
+
+ #define COMPRESSOR_TRACE_STAGE(name)   const Tracing::ScopedStage JUCE_JOIN_MACRO (traceStage_, __LINE__) (name)
+ #define COMPRESSOR_TRACE_BLOCK()       const Tracing::ScopedBlock JUCE_JOIN_MACRO (traceBlock_, __LINE__)
+ #define COMPRESSOR_TRACE_INSTANT(name) Tracing::recordInstant (name)
+
+#else
+
+ #define COMPRESSOR_TRACE_STAGE(name)
+ #define COMPRESSOR_TRACE_BLOCK()
+ #define COMPRESSOR_TRACE_INSTANT(name)
+
+#endif
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    GainReductionMeter.cpp
+    Created: 16 Oct 2026 10:21:09pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "GainReductionMeter.h"
+
+GainReductionMeter::GainReductionMeter(){
+    // Opaque, so repainting a bar doesn't repaint the editor behind it
+    setOpaque (true);
+}
+
+void GainReductionMeter::setFrame(const MeterFrame& frame, double elapsedSeconds){
+    setBarValue (inputBar,  levelToValue (frame.inputPeak),  elapsedSeconds);
+    setBarValue (outputBar, levelToValue (frame.outputPeak), elapsedSeconds);
+    setBarValue (gainReductionBar, juce::jlimit (0.0f, 1.0f, frame.gainReductiondB / maximumGainReductiondB), elapsedSeconds);
+}
+
+void GainReductionMeter::decay(double elapsedSeconds){
+    for (int bar = 0; bar < numBars; ++bar)
+        setBarValue (static_cast<Bar> (bar), 0.0f, elapsedSeconds);
+}
+
+//==============================================================================
+void GainReductionMeter::paint(juce::Graphics& g){
+    g.fillAll (juce::Colour (0xff1b1d21));
+    
+    const juce::Colour colours[numBars] = { juce::Colour (0xff4caf80), juce::Colour (0xff4caf80), juce::Colour (0xffe0a040) };
+    const char* labels[numBars] = { "IN", "OUT", "GR" };
+    
+    for (int bar = 0; bar < numBars; ++bar)
+    {
+        auto& state = bars[(size_t) bar];
+        const auto litHeight = getLitHeight (state);
+        
+        g.setColour (juce::Colour (0xff2c3036));
+        g.fillRect (state.bounds);
+        
+        // Gain reduction hangs down from the top, the levels rise from the bottom
+        g.setColour (colours[bar]);
+        
+        if (bar == gainReductionBar)
+            g.fillRect (state.bounds.withHeight (litHeight));
+        else
+            g.fillRect (state.bounds.withTop (state.bounds.getBottom() - litHeight));
+        
+        g.setColour (juce::Colours::white.withAlpha (0.6f));
+        g.setFont (juce::FontOptions (11.0f));
+        g.drawText (labels[bar], state.bounds.getX(), state.bounds.getBottom() + 2, state.bounds.getWidth(), 14,
+                    juce::Justification::centred);
+        
+        state.paintedHeight = litHeight;
+    }
+}
+
+void GainReductionMeter::resized(){
+    auto area = getLocalBounds().reduced (6);
+    area.removeFromBottom (16);
+    
+    const auto barWidth = (area.getWidth() - 2 * 6) / numBars;
+    
+    for (auto& state : bars)
+    {
+        state.bounds = area.removeFromLeft (barWidth);
+        area.removeFromLeft (6);
+    }
+}
+
+//==============================================================================
+void GainReductionMeter::setBarValue(Bar bar, float newValue, double elapsedSeconds){
+    auto& state = bars[(size_t) bar];
+    
+    // Peaks jump up, and fall at a fixed rate in decibels
+    const auto maximumFall = static_cast<float> (elapsedSeconds * decaydBPerSecond / -minimumdB);
+    state.value = newValue >= state.value ? newValue
+                                          : juce::jmax (newValue, state.value - maximumFall);
+    
+    if (getLitHeight (state) != state.paintedHeight)
+        repaint (getDirtyArea (state));
+}
+
+juce::Rectangle<int> GainReductionMeter::getDirtyArea(const BarState& state) const{
+    const auto litHeight = getLitHeight (state);
+    const auto low  = juce::jmin (litHeight, state.paintedHeight);
+    const auto high = juce::jmax (litHeight, state.paintedHeight);
+    
+    if (&state == &bars[gainReductionBar])
+        return state.bounds.withTop (state.bounds.getY() + low).withHeight (high - low);
+    
+    return state.bounds.withTop (state.bounds.getBottom() - high).withHeight (high - low);
+}
+
+int GainReductionMeter::getLitHeight(const BarState& state) const{
+    return juce::roundToInt (state.value * (float) state.bounds.getHeight());
+}
+
+float GainReductionMeter::levelToValue(float gain){
+    const auto decibels = juce::Decibels::gainToDecibels (gain, minimumdB);
+    return juce::jlimit (0.0f, 1.0f, (decibels - minimumdB) / -minimumdB);
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    GainReductionMeter.h
+    Created: 16 Oct 2026 10:21:09pm
+    Author:  Chris
+ 
+    Input and output level bars with the gain reduction between them. The
+    owner feeds it MeterFrames at its own frame rate, and only the parts of
+    the bars that moved by at least a pixel are repainted.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../Processing/Metering.h"
+
+class GainReductionMeter : public juce::Component {
+public:
+    //==============================================================================
+    GainReductionMeter();
+    
+    /** Takes the levels of everything processed since the last call.
+        elapsedSeconds is the time since then, for the decay of the bars. */
+    void setFrame (const MeterFrame& frame, double elapsedSeconds);
+    
+    /** Lets the bars fall when nothing was processed */
+    void decay (double elapsedSeconds);
+    
+    //==============================================================================
+    void paint (juce::Graphics& g) override;
+    void resized () override;
+    
+private:
+    //==============================================================================
+    enum Bar { inputBar, outputBar, gainReductionBar, numBars };
+    
+    /** One bar, with the fraction of its height it is lit and the last
+        height painted, in pixels */
+    struct BarState {
+        juce::Rectangle<int> bounds;
+        float value = 0.0f;
+        int paintedHeight = 0;
+    };
+    
+    void setBarValue (Bar bar, float newValue, double elapsedSeconds);
+    
+    /** The part of a bar between its painted height and its current one */
+    juce::Rectangle<int> getDirtyArea (const BarState& state) const;
+    
+    int getLitHeight (const BarState& state) const;
+    
+    static float levelToValue (float gain);
+    
+    static constexpr float minimumdB = -60.0f, maximumGainReductiondB = 30.0f;
+    static constexpr float decaydBPerSecond = 24.0f;
+    
+    std::array<BarState, numBars> bars;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainReductionMeter)
+};
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    TransferCurve.cpp
+    Created: 16 Oct 2026 10:03:44pm
+    Author:  Chris
+
+  ==============================================================================
+*/
+
+#include "TransferCurve.h"
+
+TransferCurve::TransferCurve(){
+    setOpaque (true);
+}
+
+void TransferCurve::setCurve(float newThresholddB, float newRatio, float newKneedB){
+    if (newThresholddB == thresholddB && newRatio == ratio && newKneedB == kneedB)
+        return;
+    
+    thresholddB = newThresholddB;
+    ratio = newRatio;
+    kneedB = newKneedB;
+    
+    renderImage();
+    repaint();
+}
+
+//==============================================================================
+void TransferCurve::paint(juce::Graphics& g){
+    if (image.isValid())
+        g.drawImage (image, getLocalBounds().toFloat());
+}
+
+void TransferCurve::resized(){
+    renderImage();
+}
+
+//==============================================================================
+void TransferCurve::renderImage(){
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+    
+    // Rendered at the display's scale, so it stays sharp on high DPI screens
+    const auto scale  = juce::Component::getApproximateScaleFactorForComponent (this);
+    const auto width  = juce::roundToInt (getWidth()  * scale);
+    const auto height = juce::roundToInt (getHeight() * scale);
+    
+    if (! image.isValid() || image.getWidth() != width || image.getHeight() != height)
+        image = juce::Image (juce::Image::RGB, width, height, false);
+    
+    juce::Graphics g (image);
+    g.addTransform (juce::AffineTransform::scale (scale));
+    
+    const auto bounds = getLocalBounds().toFloat();
+    
+    auto toX = [&] (float decibels) { return juce::jmap (decibels, minimumdB, maximumdB, bounds.getX(), bounds.getRight()); };
+    auto toY = [&] (float decibels) { return juce::jmap (decibels, minimumdB, maximumdB, bounds.getBottom(), bounds.getY()); };
+    
+    g.fillAll (juce::Colour (0xff1b1d21));
+    
+    // Grid every 10 dB
+    g.setColour (juce::Colour (0xff2c3036));
+    
+    for (auto decibels = minimumdB; decibels <= maximumdB; decibels += 10.0f)
+    {
+        g.drawVerticalLine   (juce::roundToInt (toX (decibels)), bounds.getY(), bounds.getBottom());
+        g.drawHorizontalLine (juce::roundToInt (toY (decibels)), bounds.getX(), bounds.getRight());
+    }
+    
+    // Unity line, and the threshold
+    g.setColour (juce::Colour (0xff4a4f57));
+    g.drawLine (toX (minimumdB), toY (minimumdB), toX (maximumdB), toY (maximumdB), 1.0f);
+    
+    g.setColour (juce::Colour (0x66e0a040));
+    g.drawVerticalLine (juce::roundToInt (toX (thresholddB)), bounds.getY(), bounds.getBottom());
+    
+    // The curve itself, one point per pixel column
+    juce::Path curve;
+    curve.startNewSubPath (toX (minimumdB), toY (getOutputDecibels (minimumdB)));
+    
+    for (auto x = 1; x <= getWidth(); ++x)
+    {
+        const auto inputdB = juce::jmap (static_cast<float> (x), 0.0f, static_cast<float> (getWidth()), minimumdB, maximumdB);
+        curve.lineTo (toX (inputdB), toY (getOutputDecibels (inputdB)));
+    }
+    
+    g.setColour (juce::Colour (0xffe0a040));
+    g.strokePath (curve, juce::PathStrokeType (2.0f));
+    
+    g.setColour (juce::Colours::white.withAlpha (0.6f));
+    g.setFont (juce::FontOptions (12.0f));
+    g.drawText (juce::String (thresholddB, 1) + " dB  " + juce::String (ratio, 0) + ":1"
+                  + (kneedB > 0.0f ? "  " + juce::String (kneedB, 1) + " dB knee" : juce::String()),
+                bounds.reduced (6.0f), juce::Justification::topLeft);
+}
+
+float TransferCurve::getOutputDecibels(float inputdB) const{
+    // The same curve as the compressor's VCA, quadratic across the knee
+    const auto overshoot = inputdB - thresholddB;
+    const auto inKnee    = juce::jlimit (0.0f, kneedB, overshoot + kneedB * 0.5f);
+    const auto aboveKnee = juce::jmax (0.0f, overshoot - kneedB * 0.5f);
+    const auto bent      = kneedB > 0.0f ? inKnee * inKnee / (2.0f * kneedB) + aboveKnee : juce::jmax (0.0f, overshoot);
+    
+    return inputdB + bent * (1.0f / ratio - 1.0f);
+}
@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    TransferCurve.h
+    Created: 16 Oct 2026 10:03:44pm
+    Author:  Chris
+ 
+    Input level against output level for the current threshold, ratio and knee.
+    The curve only changes with the parameters, so it is rendered once into
+    an image and paint() just blits it.
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class TransferCurve : public juce::Component {
+public:
+    //==============================================================================
+    TransferCurve();
+    
+    /** Re-renders the cached image, if the curve actually changed */
+    void setCurve (float newThresholddB, float newRatio, float newKneedB);
+    
+    //==============================================================================
+    void paint (juce::Graphics& g) override;
+    void resized () override;
+    
+private:
+    //==============================================================================
+    void renderImage ();
+    
+    /** Output level in decibels for an input level in decibels */
+    float getOutputDecibels (float inputdB) const;
+    
+    static constexpr float minimumdB = -60.0f, maximumdB = 10.0f;
+    
+    juce::Image image;
+    float thresholddB = 0.0f, ratio = 4.0f, kneedB = 0.0f;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransferCurve)
+};
@@ -0,0 +1,405 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+ 
+    Headless batch renderer: runs the channel strip over audio files offline,
+    with the same parameter layout as the plugin.
+
+    BatchRenderer [options] <files or directories>...
+
+      --output <dir>              where the rendered files go (required)
+      --set <ID>=<value>          sets a parameter, using the same text as
+                                  the plugin, e.g. THRESHOLD=-18 RATIO=8:1
+      --threads <n>               worker threads, defaults to the core count
+      --block <n>                 samples per processed block (512)
+      --precision <float|double>  sample type of the DSP (float)
+
+    Below the full gain rate (GAIN_RATE) the summary line of each file also
+    reports how far the interpolated gain got from the full rate one. That
+    costs about as much as rendering at the full gain rate.
+
+    Every file is streamed block by block, so memory use only depends on the
+    block size and the channel count, not on the length of the file. Files
+    are spread over a thread pool, one job per file.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/Parameters.h"
+#include "../../../Source/Processing/Metering.h"
+
+//==============================================================================
+/** Only here to own the parameter tree, so the renderer parses values with the
+    exact ranges and choices of the plugin. */
+class ParameterHost  : public juce::AudioProcessor
+{
+public:
+    ParameterHost()
+        : treeState (*this, nullptr, "PARAMS", Parameters::createParameterLayout())
+    {
+    }
+
+    const juce::String getName() const override                          { return "BatchRenderer"; }
+    void prepareToPlay (double, int) override                            {}
+    void releaseResources() override                                     {}
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+    double getTailLengthSeconds() const override                         { return 0.0; }
+    bool acceptsMidi() const override                                    { return false; }
+    bool producesMidi() const override                                   { return false; }
+    bool hasEditor() const override                                      { return false; }
+    juce::AudioProcessorEditor* createEditor() override                  { return nullptr; }
+    int getNumPrograms() override                                        { return 1; }
+    int getCurrentProgram() override                                     { return 0; }
+    void setCurrentProgram (int) override                                {}
+    const juce::String getProgramName (int) override                     { return {}; }
+    void changeProgramName (int, const juce::String&) override           {}
+    void getStateInformation (juce::MemoryBlock&) override               {}
+    void setStateInformation (const void*, int) override                 {}
+
+    juce::AudioProcessorValueTreeState treeState;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterHost)
+};
+
+//==============================================================================
+struct RenderSettings
+{
+    juce::File outputDirectory;
+    int numThreads = juce::SystemStats::getNumCpus();
+    int blockSize = 512;
+    bool useDoublePrecision = false;
+    Parameters::Snapshot parameters;
+};
+
+/** What the summary line of a file reports. The deviation of the control
+    rate gain from the full rate one is only measured when the gain rate
+    isn't full, see Compressor::setDeviationMeasurementEnabled(). */
+struct RenderSummary
+{
+    float outputPeak = 0.0f, gainReductiondB = 0.0f;
+    float gainRateDeviationdB = 0.0f;
+};
+
+/** Shared by every job, the main thread waits on finished */
+struct RenderStatus
+{
+    std::atomic<int> numRemaining { 0 }, numFailed { 0 };
+    juce::WaitableEvent finished;
+    juce::CriticalSection printLock;
+
+    void print (const juce::String& message)
+    {
+        const juce::ScopedLock sl (printLock);
+        std::cout << message << std::endl;
+    }
+};
+
+//==============================================================================
+template <typename SampleType>
+static bool renderStream (juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer,
+                          const RenderSettings& settings, RenderSummary& summary)
+{
+    const auto numChannels = static_cast<int> (reader.numChannels);
+    const auto blockSize   = settings.blockSize;
+
+    ChannelStrip<SampleType> channelStrip;
+    Parameters::applySnapshot (channelStrip, settings.parameters, settings.parameters, true);
+    channelStrip.setMeteringEnabled (true);
+    channelStrip.getCompressor().setDeviationMeasurementEnabled (settings.parameters.gainRateInterval > 1);
+    channelStrip.prepare ({ reader.sampleRate, static_cast<juce::uint32> (blockSize),
+                            static_cast<juce::uint32> (numChannels) });
+
+    // Both buffers are allocated once, the file is streamed through them
+    juce::AudioBuffer<float> fileBuffer (numChannels, blockSize);
+    juce::AudioBuffer<SampleType> processBuffer;
+
+    if constexpr (! std::is_same_v<SampleType, float>)
+        processBuffer.setSize (numChannels, blockSize);
+
+    MeterQueue meterQueue;
+
+    // The lookahead and the oversampling delay the output, so the first latency
+    // samples are dropped and the input is padded with as much silence at the
+    // end to stay aligned
+    const auto latency     = static_cast<juce::int64> (channelStrip.getLatencySamples());
+    const auto totalLength = reader.lengthInSamples + latency;
+
+    for (juce::int64 position = 0; position < totalLength; position += blockSize)
+    {
+        const auto numSamples = static_cast<int> (juce::jmin<juce::int64> (blockSize, totalLength - position));
+        const auto numToRead  = static_cast<int> (juce::jlimit<juce::int64> (0, numSamples, reader.lengthInSamples - position));
+
+        if (numToRead > 0 && ! reader.read (&fileBuffer, 0, numToRead, position, true, true))
+            return false;
+
+        if (numToRead < numSamples)
+            fileBuffer.clear (numToRead, numSamples - numToRead);
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            auto block = juce::dsp::AudioBlock<float> (fileBuffer).getSubBlock (0, static_cast<size_t> (numSamples));
+            channelStrip.process (juce::dsp::ProcessContextReplacing<float> (block));
+        }
+        else
+        {
+            processBuffer.makeCopyOf (fileBuffer, true);
+            auto block = juce::dsp::AudioBlock<SampleType> (processBuffer).getSubBlock (0, static_cast<size_t> (numSamples));
+            channelStrip.process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+            fileBuffer.makeCopyOf (processBuffer, true);
+        }
+
+        // Same path as the plugin's meters, one frame per block through the queue
+        meterQueue.push (MeterFrame::fromLevels<SampleType> (channelStrip.getLevels()));
+        channelStrip.resetLevels();
+
+        MeterFrame frame;
+
+        while (meterQueue.pop (frame))
+        {
+            summary.outputPeak      = juce::jmax (summary.outputPeak, frame.outputPeak);
+            summary.gainReductiondB = juce::jmax (summary.gainReductiondB, frame.gainReductiondB);
+        }
+
+        const auto numToSkip = static_cast<int> (juce::jlimit<juce::int64> (0, numSamples, latency - position));
+
+        if (numToSkip < numSamples && ! writer.writeFromAudioSampleBuffer (fileBuffer, numToSkip, numSamples - numToSkip))
+            return false;
+    }
+
+    summary.gainRateDeviationdB = static_cast<float> (channelStrip.getCompressor().getControlRateDeviationDecibels());
+    return true;
+}
+
+//==============================================================================
+class RenderJob  : public juce::ThreadPoolJob
+{
+public:
+    RenderJob (const juce::File& input, const juce::File& output, const RenderSettings& renderSettings,
+               juce::AudioFormatManager& manager, RenderStatus& renderStatus)
+        : juce::ThreadPoolJob (input.getFileName()),
+          inputFile (input), outputFile (output), settings (renderSettings),
+          formatManager (manager), status (renderStatus)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        RenderSummary summary;
+        const auto error = render (summary);
+
+        if (error.isEmpty())
+        {
+            auto levels = "output peak " + juce::String (juce::Decibels::gainToDecibels (summary.outputPeak), 1) + " dB"
+                          + ", max gain reduction " + juce::String (summary.gainReductiondB, 1) + " dB";
+
+            if (settings.parameters.gainRateInterval > 1)
+                levels << ", gain rate deviation " << juce::String (summary.gainRateDeviationdB, 3) << " dB";
+
+            status.print ("Rendered " + outputFile.getFullPathName() + " (" + levels + ")");
+        }
+        else
+        {
+            status.print ("Failed " + inputFile.getFullPathName() + ": " + error);
+            ++status.numFailed;
+        }
+
+        if (--status.numRemaining == 0)
+            status.finished.signal();
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::String render (RenderSummary& summary)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputFile));
+
+        if (reader == nullptr)
+            return "unsupported or unreadable file";
+
+        auto* format = formatManager.findFormatForFileExtension (outputFile.getFileExtension());
+
+        if (format == nullptr)
+            return "no writer for " + outputFile.getFileExtension();
+
+        outputFile.getParentDirectory().createDirectory();
+        outputFile.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream> (outputFile);
+
+        if (stream->failedToOpen())
+            return "can't write " + outputFile.getFullPathName();
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), reader->sampleRate,
+                                                                                  reader->numChannels,
+                                                                                  static_cast<int> (reader->bitsPerSample),
+                                                                                  reader->metadataValues, 0));
+
+        if (writer == nullptr)
+            return "the format doesn't support this channel count, rate or bit depth";
+
+        stream.release(); // now owned by the writer
+
+        const auto rendered = settings.useDoublePrecision ? renderStream<double> (*reader, *writer, settings, summary)
+                                                          : renderStream<float>  (*reader, *writer, settings, summary);
+
+        return rendered ? juce::String() : juce::String ("read or write error");
+    }
+
+    juce::File inputFile, outputFile;
+    const RenderSettings& settings;
+    juce::AudioFormatManager& formatManager;
+    RenderStatus& status;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "usage: BatchRenderer --output <dir> [--set ID=value]... [--threads n] [--block n]\n"
+                 "                     [--precision float|double] <files or directories>..." << std::endl;
+}
+
+static bool setParameter (ParameterHost& host, const juce::String& assignment)
+{
+    const auto parameterID = assignment.upToFirstOccurrenceOf ("=", false, false).trim();
+    const auto valueText   = assignment.fromFirstOccurrenceOf ("=", false, false).trim();
+
+    auto* parameter = host.treeState.getParameter (parameterID);
+
+    if (parameter == nullptr || valueText.isEmpty())
+    {
+        std::cout << "Unknown parameter or missing value: " << assignment << std::endl;
+        return false;
+    }
+
+    parameter->setValueNotifyingHost (parameter->getValueForText (valueText));
+    return true;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ParameterHost host;
+    RenderSettings settings;
+    juce::Array<juce::File> inputs;
+
+    juce::StringArray arguments;
+
+    for (int i = 1; i < argc; ++i)
+        arguments.add (juce::String::fromUTF8 (argv[i]));
+
+    for (int i = 0; i < arguments.size(); ++i)
+    {
+        const auto& argument = arguments[i];
+        const auto hasValue = i + 1 < arguments.size();
+
+        if (argument == "--output" && hasValue)
+            settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (arguments[++i]);
+        else if (argument == "--set" && hasValue)
+        {
+            if (! setParameter (host, arguments[++i]))
+                return 1;
+        }
+        else if (argument == "--threads" && hasValue)
+            settings.numThreads = juce::jmax (1, arguments[++i].getIntValue());
+        else if (argument == "--block" && hasValue)
+            settings.blockSize = juce::jlimit (16, 65536, arguments[++i].getIntValue());
+        else if (argument == "--precision" && hasValue)
+        {
+            const auto& precision = arguments[++i];
+
+            if (precision != "float" && precision != "double")
+            {
+                std::cout << "Unknown precision: " << precision << std::endl;
+                return 1;
+            }
+
+            settings.useDoublePrecision = precision == "double";
+        }
+        else if (argument.startsWith ("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            inputs.add (juce::File::getCurrentWorkingDirectory().getChildFile (argument));
+    }
+
+    if (settings.outputDirectory == juce::File() || inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    settings.parameters = Parameters::readSnapshot (host.treeState);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    // Directories keep their structure below the output directory
+    juce::Array<juce::File> sources, destinations;
+
+    for (const auto& input : inputs)
+    {
+        if (input.isDirectory())
+        {
+            for (const auto& file : input.findChildFiles (juce::File::findFiles, true, formatManager.getWildcardForAllFormats()))
+            {
+                sources.add (file);
+                destinations.add (settings.outputDirectory.getChildFile (file.getRelativePathFrom (input)));
+            }
+        }
+        else if (input.existsAsFile())
+        {
+            sources.add (input);
+            destinations.add (settings.outputDirectory.getChildFile (input.getFileName()));
+        }
+        else
+        {
+            std::cout << "No such file or directory: " << input.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    for (int i = sources.size(); --i >= 0;)
+    {
+        if (sources[i] == destinations[i])
+        {
+            std::cout << "Refusing to overwrite " << sources[i].getFullPathName() << std::endl;
+            return 1;
+        }
+
+        // e.g. a/kick.wav and b/kick.wav, two jobs would write the same file
+        if (const auto first = destinations.indexOf (destinations[i]); first != i)
+        {
+            std::cout << sources[first].getFullPathName() << " and " << sources[i].getFullPathName()
+                      << " would both render to " << destinations[i].getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (sources.isEmpty())
+        return 0;
+
+    RenderStatus status;
+    status.numRemaining = sources.size();
+
+    {
+        juce::ThreadPool pool (juce::jmin (settings.numThreads, sources.size()));
+
+        for (int i = 0; i < sources.size(); ++i)
+            pool.addJob (new RenderJob (sources[i], destinations[i], settings, formatManager, status), true);
+
+        status.finished.wait();
+    }
+
+    std::cout << sources.size() - status.numFailed << " of " << sources.size() << " files rendered" << std::endl;
+
+    return status.numFailed > 0 ? 1 : 0;
+}
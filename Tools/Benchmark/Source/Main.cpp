@@ -0,0 +1,518 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+ 
+    Microbenchmarks for the compressor DSP. Every scenario runs the same
+    signal through either Compressor<SampleType>::process ("compressor") or
+    CompressorAudioProcessor::processBlock ("processor"), for every
+    combination of:
+
+      block size    16 to 8192 samples
+      layout        mono, stereo, 5.1, 7.1, 7.1.4, 3rd order ambisonics
+      detector      independent, or linked across the channels (max)
+      precision     float, double
+      signal        below or above the threshold
+      automation    none, or every continuous parameter changed every block
+      gain rate     full, or one gain every 8 samples (compressor only)
+
+    Below the full gain rate the JSON also holds gainRateDeviationdB, the
+    largest difference between the interpolated and the full rate gain,
+    measured in an extra pass over the signal that isn't timed.
+
+    Scenarios the processor doesn't support (a layout it rejects, or double
+    precision before it implements it) are reported as skipped.
+
+    Benchmark [--output <file>] [--seconds <s>] [--repeats <n>] [--filter <text>]
+              [--streams <n>]
+
+      --output   results as JSON (benchmark.json)
+      --seconds  length of audio rendered per repeat (2)
+      --repeats  the fastest of n repeats is reported (3)
+      --filter   only runs scenarios whose name contains the text
+      --streams  instead of the scenarios, runs n stereo streams through a
+                 StreamEngine with 1, 2, 4... threads up to the core count
+
+    The timing includes copying each block from the source signal, the way a
+    host hands a fresh buffer to the plugin every block.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/Processing/StreamEngine.h"
+
+//==============================================================================
+struct BenchmarkSettings
+{
+    juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile ("benchmark.json");
+    double sampleRate = 48000.0, secondsPerRepeat = 2.0;
+    int numRepeats = 3, numStreams = 0;
+    juce::String filter;
+};
+
+struct Scenario
+{
+    juce::String target;
+    int blockSize, numChannels;
+    bool useDoublePrecision, aboveThreshold, automated, linked;
+    int gainRateInterval;
+
+    juce::String getName() const
+    {
+        return target + "/" + juce::String (blockSize) + "/" + juce::String (numChannels) + "ch/"
+             + (useDoublePrecision ? "double" : "float") + "/"
+             + (aboveThreshold ? "above" : "below")
+             + (automated ? "/automated" : "")
+             + (linked ? "/linked" : "")
+             + (gainRateInterval > 1 ? "/gainrate" + juce::String (gainRateInterval) : juce::String());
+    }
+};
+
+struct Result
+{
+    bool skipped = true;
+    double nsPerSample = 0.0, realtimeFactor = 0.0;
+    double gainRateDeviationdB = 0.0;
+};
+
+// Threshold and peak level of the test signal, in dB
+static constexpr float belowThresholddB = -6.0f,  belowPeakdB = -24.0f;
+static constexpr float aboveThresholddB = -40.0f, abovePeakdB = -3.0f;
+
+//==============================================================================
+/** One second of a sine per channel plus some noise, so the detector sees
+    both steady and transient material and the channels differ */
+template <typename SampleType>
+static juce::AudioBuffer<SampleType> makeSignal (int numChannels, double sampleRate, float peakdB)
+{
+    const auto length = static_cast<int> (sampleRate);
+    const auto gain = juce::Decibels::decibelsToGain (peakdB) * 0.5f;
+
+    juce::AudioBuffer<SampleType> signal (numChannels, length);
+    juce::Random random (1234);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = signal.getWritePointer (channel);
+        const auto frequency = 110.0 * (channel + 1);
+
+        for (int i = 0; i < length; ++i)
+        {
+            const auto sine  = std::sin (juce::MathConstants<double>::twoPi * frequency * i / sampleRate);
+            const auto noise = random.nextFloat() * 2.0f - 1.0f;
+            data[i] = static_cast<SampleType> (gain * (sine + noise));
+        }
+    }
+
+    return signal;
+}
+
+/** Runs renderBlock over the whole length numRepeats times, and returns the
+    fastest run */
+template <typename SampleType, typename RenderBlock>
+static Result timeScenario (const Scenario& scenario, const BenchmarkSettings& settings,
+                            const juce::AudioBuffer<SampleType>& signal, RenderBlock&& renderBlock)
+{
+    const auto blockSize   = scenario.blockSize;
+    const auto numChannels = scenario.numChannels;
+    const auto numBlocks   = juce::jmax (1, static_cast<int> (settings.secondsPerRepeat * settings.sampleRate) / blockSize);
+
+    juce::AudioBuffer<SampleType> buffer (numChannels, blockSize);
+
+    auto render = [&] (int count)
+    {
+        int position = 0;
+
+        for (int block = 0; block < count; ++block)
+        {
+            if (position + blockSize > signal.getNumSamples())
+                position = 0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom (channel, 0, signal, channel, position, blockSize);
+
+            renderBlock (buffer, block);
+            position += blockSize;
+        }
+    };
+
+    // warm up the caches and the branch predictors
+    render (juce::jmin (numBlocks, 64));
+
+    auto fastest = std::numeric_limits<juce::int64>::max();
+
+    for (int repeat = 0; repeat < settings.numRepeats; ++repeat)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        render (numBlocks);
+        fastest = juce::jmin (fastest, juce::Time::getHighResolutionTicks() - start);
+    }
+
+    const auto seconds    = juce::Time::highResolutionTicksToSeconds (fastest);
+    const auto numSamples = static_cast<double> (numBlocks) * blockSize;
+
+    Result result;
+    result.skipped        = false;
+    result.nsPerSample    = seconds * 1.0e9 / (numSamples * numChannels);
+    result.realtimeFactor = (numSamples / settings.sampleRate) / seconds;
+    return result;
+}
+
+/** Slowly sweeps a value across its range, one step per block */
+static float sweep (float start, float end, int block)
+{
+    const auto phase = static_cast<float> (block % 256) / 255.0f;
+    return start + (end - start) * phase;
+}
+
+//==============================================================================
+template <typename SampleType>
+static Result runCompressor (const Scenario& scenario, const BenchmarkSettings& settings)
+{
+    const auto thresholddB = scenario.aboveThreshold ? aboveThresholddB : belowThresholddB;
+    const auto signal = makeSignal<SampleType> (scenario.numChannels, settings.sampleRate,
+                                                scenario.aboveThreshold ? abovePeakdB : belowPeakdB);
+
+    Compressor<SampleType> compressor;
+    compressor.setThreshold (thresholddB);
+    compressor.setRatio (4);
+    compressor.setAttack (400);
+    compressor.setRelease (250);
+    compressor.setDetectorLink (scenario.linked ? DetectorLink::maximum : DetectorLink::independent);
+    compressor.setControlRateInterval (scenario.gainRateInterval);
+    compressor.prepare ({ settings.sampleRate, static_cast<juce::uint32> (scenario.blockSize),
+                          static_cast<juce::uint32> (scenario.numChannels) });
+
+    auto renderBlock = [&] (juce::AudioBuffer<SampleType>& buffer, int block)
+    {
+        if (scenario.automated)
+        {
+            compressor.setThreshold (sweep (thresholddB - 6.0f, thresholddB + 6.0f, block));
+            compressor.setAttack    (sweep (20.0f, 800.0f, block));
+            compressor.setRelease   (sweep (50.0f, 1100.0f, block));
+        }
+
+        juce::dsp::AudioBlock<SampleType> audioBlock (buffer);
+        compressor.process (juce::dsp::ProcessContextReplacing<SampleType> (audioBlock));
+    };
+
+    auto result = timeScenario<SampleType> (scenario, settings, signal, renderBlock);
+
+    // The measurement costs as much as the full gain rate, so it gets a pass
+    // of its own once the timing is done
+    if (scenario.gainRateInterval > 1)
+    {
+        compressor.reset();
+        compressor.setDeviationMeasurementEnabled (true);
+
+        juce::AudioBuffer<SampleType> buffer (scenario.numChannels, scenario.blockSize);
+
+        for (int block = 0, position = 0; position + scenario.blockSize <= signal.getNumSamples(); ++block, position += scenario.blockSize)
+        {
+            for (int channel = 0; channel < scenario.numChannels; ++channel)
+                buffer.copyFrom (channel, 0, signal, channel, position, scenario.blockSize);
+
+            renderBlock (buffer, block);
+        }
+
+        result.gainRateDeviationdB = static_cast<double> (compressor.getControlRateDeviationDecibels());
+    }
+
+    return result;
+}
+
+//==============================================================================
+static juce::AudioChannelSet getChannelSet (int numChannels)
+{
+    switch (numChannels)
+    {
+        case 12: return juce::AudioChannelSet::create7point1point4();
+        case 16: return juce::AudioChannelSet::ambisonic (3);
+        default: return juce::AudioChannelSet::canonicalChannelSet (numChannels);
+    }
+}
+
+static void setParameter (CompressorAudioProcessor& processor, const juce::String& parameterID, float value)
+{
+    auto* parameter = processor.treeState.getParameter (parameterID);
+    parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+template <typename SampleType>
+static Result runProcessor (const Scenario& scenario, const BenchmarkSettings& settings)
+{
+    CompressorAudioProcessor processor;
+
+    const auto channelSet = getChannelSet (scenario.numChannels);
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses .add (channelSet);
+    layout.inputBuses .add (juce::AudioChannelSet::disabled());    // no sidechain
+    layout.outputBuses.add (channelSet);
+
+    if (! processor.setBusesLayout (layout))
+        return {};
+
+    if constexpr (std::is_same_v<SampleType, double>)
+    {
+        if (! processor.supportsDoublePrecisionProcessing())
+            return {};
+
+        processor.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+    }
+
+    const auto thresholddB = scenario.aboveThreshold ? aboveThresholddB : belowThresholddB;
+    setParameter (processor, processor.paramThreshold, thresholddB);
+    setParameter (processor, processor.paramLink, scenario.linked ? LinkChoice::LinkedMaximum : LinkChoice::Independent);
+
+    const auto signal = makeSignal<SampleType> (scenario.numChannels, settings.sampleRate,
+                                                scenario.aboveThreshold ? abovePeakdB : belowPeakdB);
+
+    processor.setRateAndBufferSizeDetails (settings.sampleRate, scenario.blockSize);
+    processor.prepareToPlay (settings.sampleRate, scenario.blockSize);
+
+    juce::MidiBuffer midi;
+
+    const auto result = timeScenario<SampleType> (scenario, settings, signal, [&] (juce::AudioBuffer<SampleType>& buffer, int block)
+    {
+        if (scenario.automated)
+        {
+            setParameter (processor, processor.paramThreshold, sweep (thresholddB - 6.0f, thresholddB + 6.0f, block));
+            setParameter (processor, processor.paramAttack,    sweep (20.0f, 800.0f, block));
+            setParameter (processor, processor.paramRelease,   sweep (50.0f, 1100.0f, block));
+            setParameter (processor, processor.paramInput,     sweep (-3.0f, 3.0f, block));
+            setParameter (processor, processor.paramOutput,    sweep (3.0f, -3.0f, block));
+        }
+
+        processor.processBlock (buffer, midi);
+    });
+
+    processor.releaseResources();
+    return result;
+}
+
+//==============================================================================
+/** Aggregate throughput of numStreams stereo streams of 512 sample blocks,
+    every stream with its own threshold, through an engine of numThreads */
+static Result runStreams (int numStreams, int numThreads, const BenchmarkSettings& settings)
+{
+    constexpr int blockSize = 512, numChannels = 2;
+
+    const auto signal = makeSignal<float> (numChannels, settings.sampleRate, abovePeakdB);
+    const auto numBlocks = juce::jmax (1, static_cast<int> (settings.secondsPerRepeat * settings.sampleRate) / blockSize);
+
+    StreamEngine<float> engine (numThreads);
+    engine.prepare (numStreams, { settings.sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+    for (int i = 0; i < numStreams; ++i)
+        engine.getCompressor (i).setThreshold (aboveThresholddB + static_cast<float> (i % 24));
+
+    juce::AudioBuffer<float> buffer (numChannels * numStreams, blockSize);
+    std::vector<juce::dsp::AudioBlock<float>> blocks;
+
+    for (int i = 0; i < numStreams; ++i)
+        blocks.push_back (juce::dsp::AudioBlock<float> (buffer).getSubsetChannelBlock ((size_t) (i * numChannels), numChannels));
+
+    auto render = [&] (int count)
+    {
+        for (int block = 0, position = 0; block < count; ++block, position += blockSize)
+        {
+            if (position + blockSize > signal.getNumSamples())
+                position = 0;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.copyFrom (channel, 0, signal, channel % numChannels, position, blockSize);
+
+            engine.process (blocks.data(), numStreams);
+        }
+    };
+
+    render (juce::jmin (numBlocks, 16));
+
+    auto fastest = std::numeric_limits<juce::int64>::max();
+
+    for (int repeat = 0; repeat < settings.numRepeats; ++repeat)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        render (numBlocks);
+        fastest = juce::jmin (fastest, juce::Time::getHighResolutionTicks() - start);
+    }
+
+    const auto seconds    = juce::Time::highResolutionTicksToSeconds (fastest);
+    const auto numSamples = static_cast<double> (numBlocks) * blockSize * numStreams;
+
+    Result result;
+    result.skipped        = false;
+    result.nsPerSample    = seconds * 1.0e9 / (numSamples * numChannels);
+    result.realtimeFactor = (numSamples / settings.sampleRate) / seconds;    // in streams
+    return result;
+}
+
+static juce::Array<juce::var> runStreamScaling (const BenchmarkSettings& settings)
+{
+    juce::Array<juce::var> results;
+
+    for (int numThreads = 1;; numThreads *= 2)
+    {
+        numThreads = juce::jmin (numThreads, juce::SystemStats::getNumCpus());
+        const auto result = runStreams (settings.numStreams, numThreads, settings);
+
+        std::cout << "streams/" << settings.numStreams << "/" << numThreads << "threads  "
+                  << juce::String (result.nsPerSample, 3) << " ns/sample  "
+                  << juce::String (result.realtimeFactor, 1) << " realtime streams" << std::endl;
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("numStreams",      settings.numStreams);
+        object->setProperty ("numThreads",      numThreads);
+        object->setProperty ("nsPerSample",     result.nsPerSample);
+        object->setProperty ("realtimeStreams", result.realtimeFactor);
+        results.add (juce::var (object));
+
+        if (numThreads == juce::SystemStats::getNumCpus())
+            return results;
+    }
+}
+
+//==============================================================================
+static Result runScenario (const Scenario& scenario, const BenchmarkSettings& settings)
+{
+    if (scenario.target == "compressor")
+        return scenario.useDoublePrecision ? runCompressor<double> (scenario, settings)
+                                           : runCompressor<float>  (scenario, settings);
+
+    return scenario.useDoublePrecision ? runProcessor<double> (scenario, settings)
+                                       : runProcessor<float>  (scenario, settings);
+}
+
+static juce::Array<Scenario> createScenarios()
+{
+    juce::Array<Scenario> scenarios;
+
+    for (auto* target : { "compressor", "processor" })
+    {
+        // The processor has no way to report the deviation, it keeps the full rate
+        const auto gainRateIntervals = juce::String (target) == "compressor" ? juce::Array<int> { 1, 8 }
+                                                                             : juce::Array<int> { 1 };
+
+        for (auto blockSize : { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 })
+            for (auto numChannels : { 1, 2, 6, 8, 12, 16 })
+                for (auto useDoublePrecision : { false, true })
+                    for (auto aboveThreshold : { false, true })
+                        for (auto automated : { false, true })
+                            for (auto linked : { false, true })
+                                for (auto gainRateInterval : gainRateIntervals)
+                                    scenarios.add ({ target, blockSize, numChannels, useDoublePrecision, aboveThreshold, automated, linked,
+                                                     gainRateInterval });
+    }
+
+    return scenarios;
+}
+
+static juce::var toJSON (const Scenario& scenario, const Result& result)
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty ("name",        scenario.getName());
+    object->setProperty ("target",      scenario.target);
+    object->setProperty ("blockSize",   scenario.blockSize);
+    object->setProperty ("numChannels", scenario.numChannels);
+    object->setProperty ("precision",   scenario.useDoublePrecision ? "double" : "float");
+    object->setProperty ("signal",      scenario.aboveThreshold ? "above" : "below");
+    object->setProperty ("automated",   scenario.automated);
+    object->setProperty ("linked",      scenario.linked);
+    object->setProperty ("gainRateInterval", scenario.gainRateInterval);
+    object->setProperty ("skipped",     result.skipped);
+
+    if (! result.skipped)
+    {
+        object->setProperty ("nsPerSample",    result.nsPerSample);
+        object->setProperty ("realtimeFactor", result.realtimeFactor);
+
+        if (scenario.gainRateInterval > 1)
+            object->setProperty ("gainRateDeviationdB", result.gainRateDeviationdB);
+    }
+
+    return juce::var (object);
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchmarkSettings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto argument = juce::String::fromUTF8 (argv[i]);
+        const auto value    = i + 1 < argc ? juce::String::fromUTF8 (argv[i + 1]) : juce::String();
+
+        if (argument == "--output" && value.isNotEmpty())
+            settings.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+        else if (argument == "--seconds" && value.isNotEmpty())
+            settings.secondsPerRepeat = juce::jmax (0.01, value.getDoubleValue());
+        else if (argument == "--repeats" && value.isNotEmpty())
+            settings.numRepeats = juce::jmax (1, value.getIntValue());
+        else if (argument == "--filter" && value.isNotEmpty())
+            settings.filter = value;
+        else if (argument == "--streams" && value.isNotEmpty())
+            settings.numStreams = juce::jmax (1, value.getIntValue());
+        else
+        {
+            std::cout << "usage: Benchmark [--output file] [--seconds s] [--repeats n] [--filter text] [--streams n]" << std::endl;
+            return 1;
+        }
+
+        ++i;
+    }
+
+    juce::Array<juce::var> results, streamResults;
+
+    if (settings.numStreams > 0)
+        streamResults = runStreamScaling (settings);
+    else
+    {
+        for (const auto& scenario : createScenarios())
+        {
+            const auto name = scenario.getName();
+
+            if (settings.filter.isNotEmpty() && ! name.contains (settings.filter))
+                continue;
+
+            const auto result = runScenario (scenario, settings);
+            results.add (toJSON (scenario, result));
+
+            if (result.skipped)
+                std::cout << name << "  skipped" << std::endl;
+            else
+            {
+                std::cout << name << "  " << juce::String (result.nsPerSample, 3) << " ns/sample  "
+                          << juce::String (result.realtimeFactor, 1) << "x realtime";
+
+                if (scenario.gainRateInterval > 1)
+                    std::cout << "  " << juce::String (result.gainRateDeviationdB, 3) << " dB gain rate deviation";
+
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("cpu",              juce::SystemStats::getCpuModel());
+    root->setProperty ("numCpus",          juce::SystemStats::getNumCpus());
+    root->setProperty ("time",             juce::Time::getCurrentTime().toISO8601 (true));
+    root->setProperty ("sampleRate",       settings.sampleRate);
+    root->setProperty ("secondsPerRepeat", settings.secondsPerRepeat);
+    root->setProperty ("repeats",          settings.numRepeats);
+    root->setProperty ("results",          results);
+
+    if (settings.numStreams > 0)
+        root->setProperty ("streams", streamResults);
+
+    if (! settings.outputFile.replaceWithText (juce::JSON::toString (juce::var (root))))
+    {
+        std::cout << "Couldn't write " << settings.outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1371 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    Numerical conformance of the optimized compressor against
+    ReferenceCompressor, the scalar per sample implementation. Every case
+    renders the same random signal through both, sample by sample, for every
+    combination of:
+
+      path          processBlock with the exact engine, with the fast
+                    engine, with the channels linked by their maximum and
+                    by their mean, at a control rate, with the threshold
+                    ramping, with lookahead, with an external key, with the
+                    detector high-pass and with the RMS detector, and
+                    ChannelStrip with its input and output gains fused into
+                    the compressor, oversampled, and with the bypass
+                    crossfading
+      precision     float, double
+      ratio         every ratio choice of the plugin
+      layout        1, 2, 3, 5, 8 and 9 channels, so the SIMD lanes are
+                    full, partly used and spill over into another register
+      block size    1 to 4096 samples, or a random size every block
+
+    The threshold, knee, attack and release of each case are random. The
+    attack and release alternate between the ends of their ranges and a
+    random value in between. The threshold ramp and the channel strip cases
+    move the threshold, or the gains, to random values at random blocks, and
+    the reference follows the ramps sample by sample. The linked references
+    combine the channels the way the linked detector does, and the lookahead
+    reference delays the audio, not the detector, by the compressor's
+    getLatencySamples().
+
+    The key is mono, one channel per input channel, narrower or wider than
+    the input, and once wider than Compressor::maxKeyChannels, at the full
+    rate or held for 2 or 4 samples. The references of the key, the
+    high-pass and the RMS detector compute their detector signal on their
+    own, see ReferenceDetector, the RMS one with a plain sum over its whole
+    window on every sample. The oversampled reference resamples with JUCE's
+    filters around a reference at the oversampled rate, and its tolerance
+    grows by how much the filters back down may add up the errors of the
+    oversampled samples. Some of the cases at 8 times the rate high-pass the
+    detector at 20 Hz, where the biquad needs the most precision. The bypass
+    reference mixes in the input the way ChannelStrip documents it.
+
+    ReferenceCompressor is anchored in turn: the baseline cases run the
+    compressor as it was before any of the optimizations, verbatim, a
+    juce::dsp::BallisticsFilter<float> and std::pow in float, and the float
+    reference with a hard knee has to give the same samples, bit for bit.
+    The double reference is the same arithmetic in double, it can't match
+    the float baseline more closely than the float rounding of the envelope.
+
+    Conformance [--seed <n>] [--seconds <s>] [--verbose]
+
+      --seed     seed of the random signals and parameters (1)
+      --seconds  length of the signal of each case (0.5)
+      --verbose  prints every case, not only the failing ones
+
+    Reports the largest gain error in dB and the null test residual (the
+    difference to the reference, as a peak in dBFS and as its RMS relative
+    to the reference's) per path and precision. Returns 1 when any case
+    exceeds the tolerances of its path. At a control rate the reference
+    interpolates its own gains between the same control points, so the
+    tolerances stay those of the exact engine, and the deviation the
+    compressor measured between its interpolated and its full rate gain has
+    to match the one of the reference.
+
+    In float the SIMD code doesn't round like the reference, it orders and
+    fuses its operations its own way. So every float case also renders the
+    reference in double, and may be off from the float reference by twice
+    as much as that is off from the double one. At 8 times 48 kHz the float
+    envelope of a slow release is up to about 0.007 dB off the double one.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/Processing/ChannelStrip.h"
+#include "../../../Source/Processing/ReferenceCompressor.h"
+
+//==============================================================================
+enum class Path { exactBlock, fastBlock, linkedBlock, meanLinkedBlock, controlRate, thresholdRamp, lookahead,
+                  sidechain, highPass, rms, channelStrip, oversampledStrip, bypass };
+
+static const char* getPathName (Path path)
+{
+    switch (path)
+    {
+        case Path::exactBlock:       return "exact";
+        case Path::fastBlock:        return "fast";
+        case Path::linkedBlock:      return "linked";
+        case Path::meanLinkedBlock:  return "mean";
+        case Path::controlRate:      return "controlrate";
+        case Path::thresholdRamp:    return "ramp";
+        case Path::lookahead:        return "lookahead";
+        case Path::sidechain:        return "sidechain";
+        case Path::highPass:         return "highpass";
+        case Path::rms:              return "rms";
+        case Path::channelStrip:     return "strip";
+        case Path::oversampledStrip: return "oversampled";
+        case Path::bypass:           return "bypass";
+    }
+
+    return "";
+}
+
+/** How far a path may be from the reference. The exact kernels stay within a
+    few ulps of std::pow, the fast engine within the bounds of FastMath.h. A
+    control rate changes nothing, the reference interpolates the same way.
+    The deviation a control rate measures is a ratio of two gains, each of
+    which may be maxErrordB off, so it may be twice that off. The key, the
+    high-pass and the bypass are exact too, the RMS detector is once its
+    reference is within the bounds of the running sum. The oversampled
+    strip scales these by getReconstructionGain(). In float they are only
+    the least a case is allowed, see addFloatError(). */
+struct Tolerance
+{
+    double maxErrordB, maxResidualdB;
+};
+
+template <typename SampleType>
+static Tolerance getTolerance (Path path)
+{
+    constexpr auto isFloat = std::is_same_v<SampleType, float>;
+
+    if (path == Path::fastBlock)
+        return { 1.0e-4, -100.0 };
+
+    return isFloat ? Tolerance { 1.0e-4, -110.0 }
+                   : Tolerance { 1.0e-9, -250.0 };
+}
+
+struct ConformanceSettings
+{
+    double sampleRate = 48000.0, seconds = 0.5;
+    juce::int64 seed = 1;
+    bool verbose = false;
+};
+
+struct Case
+{
+    Path path;
+    bool useDoublePrecision;
+    int ratio, numChannels, blockSize;    // 0 picks a random size every block
+    float thresholddB, kneedB, attackTime, releaseTime;
+    DetectorLink detectorLink = DetectorLink::independent;
+    int controlRateInterval = 1;
+    float lookaheadTime = 0.0f;           // in milliseconds
+    double rampSeconds = 0.0;             // of the threshold, and of the strip's gains
+    int numKeyChannels = 0, keyRateShift = 0;
+    float highPassFrequency = 0.0f;       // 0 is off
+    float rmsWindowTime = 0.0f;           // in milliseconds, 0 is the peak detector
+    int oversamplingFactorLog2 = 0;
+    bool useLinearPhase = false;
+
+    juce::String getName() const
+    {
+        auto name = juce::String (getPathName (path)) + "/" + (useDoublePrecision ? "double" : "float") + "/"
+                  + juce::String (ratio) + ":1/" + juce::String (numChannels) + "ch/"
+                  + (blockSize > 0 ? juce::String (blockSize) : juce::String ("random")) + "/"
+                  + juce::String (thresholddB, 1) + "dB/knee " + juce::String (kneedB, 1) + "dB/"
+                  + juce::String (attackTime, 1) + "us/" + juce::String (releaseTime, 1) + "ms";
+
+        if (detectorLink != DetectorLink::independent)
+            name += detectorLink == DetectorLink::mean ? "/mean" : "/max";
+
+        if (controlRateInterval > 1)
+            name += "/every " + juce::String (controlRateInterval);
+
+        if (numKeyChannels > 0)
+            name += "/key " + juce::String (numKeyChannels) + "ch" + (keyRateShift > 0 ? " held " + juce::String (1 << keyRateShift) : juce::String());
+
+        if (highPassFrequency > 0.0f)
+            name += "/high-pass " + juce::String (highPassFrequency, 1) + "Hz";
+
+        if (rmsWindowTime > 0.0f)
+            name += "/rms " + juce::String (rmsWindowTime, 2) + "ms";
+
+        if (oversamplingFactorLog2 > 0)
+            name += "/" + juce::String (1 << oversamplingFactorLog2) + "x " + (useLinearPhase ? "fir" : "iir");
+
+        if (lookaheadTime > 0.0f)
+            name += "/lookahead " + juce::String (lookaheadTime, 2) + "ms";
+
+        if (rampSeconds > 0.0)
+            name += "/ramp " + juce::String (rampSeconds * 1000.0, 1) + "ms";
+
+        return name;
+    }
+};
+
+/** One block of a case, and what changes right before it */
+struct Block
+{
+    int position, numSamples;
+    bool isAutomated;
+    float thresholddB, inputGaindB, outputGaindB;
+    bool isBypassed;
+};
+
+struct Result
+{
+    double maxErrordB = 0.0, peakResidualdB = -400.0, residualdB = -400.0, deviationErrordB = 0.0;
+    bool passed = true;
+};
+
+static constexpr int maxBlockSize = 4096;
+
+//==============================================================================
+/** Segments of noise, sines, bursts and silence at random levels, so the
+    envelope crosses the threshold both ways and the silent and below
+    threshold shortcuts of processBlock get their share */
+template <typename SampleType>
+static juce::AudioBuffer<SampleType> makeSignal (int numChannels, int length, double sampleRate, juce::Random& random)
+{
+    juce::AudioBuffer<SampleType> signal (numChannels, length);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = signal.getWritePointer (channel);
+
+        for (int position = 0; position < length;)
+        {
+            const auto segmentLength = juce::jmin (length - position, 64 + random.nextInt (8192));
+            const auto gain      = juce::Decibels::decibelsToGain (random.nextFloat() * 86.0f - 80.0f);
+            const auto frequency = 20.0 + random.nextDouble() * 8000.0;
+
+            switch (random.nextInt (4))
+            {
+                case 0:
+                    for (int i = 0; i < segmentLength; ++i)
+                        data[position + i] = static_cast<SampleType> (gain * (random.nextFloat() * 2.0f - 1.0f));
+                    break;
+
+                case 1:
+                    for (int i = 0; i < segmentLength; ++i)
+                        data[position + i] = static_cast<SampleType> (gain * std::sin (juce::MathConstants<double>::twoPi * frequency * i / sampleRate));
+                    break;
+
+                case 2:
+                    for (int i = 0; i < segmentLength; ++i)
+                        data[position + i] = static_cast<SampleType> (i % 256 < 16 ? gain * (random.nextFloat() * 2.0f - 1.0f) : 0.0f);
+                    break;
+
+                default:
+                    std::fill (data + position, data + position + segmentLength, static_cast<SampleType> (0.0));
+                    break;
+            }
+
+            position += segmentLength;
+        }
+    }
+
+    return signal;
+}
+
+/** Compares output to reference, sample by sample. With a levelRadius, the
+    output isn't the input times a gain but filtered after the gain, so the
+    error of a sample is taken relative to the largest reference within
+    levelRadius samples, rather than to the reference of the sample. */
+template <typename SampleType>
+static Result compare (const juce::AudioBuffer<SampleType>& output, const juce::AudioBuffer<SampleType>& reference,
+                       const Tolerance& tolerance, int levelRadius = 0)
+{
+    double maxError = 0.0, peakResidual = 0.0, residualSquares = 0.0, referenceSquares = 0.0;
+
+    for (int channel = 0; channel < output.getNumChannels(); ++channel)
+    {
+        const auto* outputSamples    = output   .getReadPointer (channel);
+        const auto* referenceSamples = reference.getReadPointer (channel);
+
+        for (int i = 0; i < output.getNumSamples(); ++i)
+        {
+            const auto outputValue    = static_cast<double> (outputSamples[i]);
+            const auto referenceValue = static_cast<double> (referenceSamples[i]);
+            const auto residual = std::abs (outputValue - referenceValue);
+
+            peakResidual      = juce::jmax (peakResidual, residual);
+            residualSquares  += residual * residual;
+            referenceSquares += referenceValue * referenceValue;
+
+            if (levelRadius > 0)
+            {
+                auto level = 0.0;
+
+                for (int j = juce::jmax (0, i - levelRadius); j <= juce::jmin (output.getNumSamples() - 1, i + levelRadius); ++j)
+                    level = juce::jmax (level, std::abs (static_cast<double> (referenceSamples[j])));
+
+                if (residual > 0.0)
+                    maxError = juce::jmax (maxError, level > 0.0 ? 20.0 * std::log10 (1.0 + residual / level)
+                                                                 : std::numeric_limits<double>::infinity());
+            }
+            // Both are the input times a gain, so their ratio is the ratio of
+            // the gains. A zero on one side only is as far apart as it gets.
+            else if (referenceValue != 0.0 && outputValue != 0.0)
+                maxError = juce::jmax (maxError, std::abs (20.0 * std::log10 (outputValue / referenceValue)));
+            else if (referenceValue != outputValue)
+                maxError = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    const auto toDecibels = [] (double value) { return value > 0.0 ? 20.0 * std::log10 (value) : -400.0; };
+
+    Result result;
+    result.maxErrordB     = maxError;
+    result.peakResidualdB = toDecibels (peakResidual);
+    result.residualdB     = referenceSquares > 0.0 ? toDecibels (std::sqrt (residualSquares / referenceSquares))
+                                                   : result.peakResidualdB;
+    result.passed = result.maxErrordB <= tolerance.maxErrordB && result.residualdB <= tolerance.maxResidualdB;
+    return result;
+}
+
+//==============================================================================
+/** ParameterRamp's contract, in double: a ramp starts on the sample after it
+    was set and ends exactly on its target. Setting the target it already
+    has changes nothing. */
+struct LinearRamp
+{
+    double start = 1.0, target = 1.0;
+    int length = 0, position = 0;
+
+    double getCurrent() const { return position < length ? start + (target - start) * position / length : target; }
+
+    void jumpTo (double value)
+    {
+        start = target = value;
+        length = position = 0;
+    }
+
+    void rampTo (double newTarget, int rampLength)
+    {
+        if (newTarget == target)
+            return;
+
+        if (rampLength <= 0)
+        {
+            jumpTo (newTarget);
+            return;
+        }
+
+        start    = getCurrent();
+        target   = newTarget;
+        length   = rampLength;
+        position = 0;
+    }
+
+    double getNext()
+    {
+        position = juce::jmin (length, position + 1);
+        return getCurrent();
+    }
+};
+
+static bool isStrip (Path path)
+{
+    return path == Path::channelStrip || path == Path::oversampledStrip || path == Path::bypass;
+}
+
+/** The block sizes of a case, and for the threshold ramp and the channel
+    strip, new values for the threshold or the gains every few thousand
+    samples. The bypass cases also switch the bypass on or off there, so
+    some fades finish and some are turned around halfway. With a key held
+    for 2^keyRateShift samples, the blocks are whole key samples long. */
+static std::vector<Block> createBlocks (const Case& testCase, int length, juce::Random& random)
+{
+    const auto isAutomated = testCase.path == Path::thresholdRamp || isStrip (testCase.path);
+
+    std::vector<Block> blocks;
+    auto nextChange = 1 + random.nextInt (4800);
+    auto isBypassed = false;
+
+    for (int position = 0; position < length;)
+    {
+        const auto blockSize = (testCase.blockSize > 0 ? testCase.blockSize : 1 + random.nextInt (1024)) << testCase.keyRateShift;
+        Block block { position, juce::jmin (blockSize, length - position), false, testCase.thresholddB, 0.0f, 0.0f, isBypassed };
+
+        if (isAutomated && position >= nextChange)
+        {
+            block.isAutomated  = true;
+            block.thresholddB  = testCase.path == Path::thresholdRamp ? -60.0f + random.nextFloat() * 70.0f : testCase.thresholddB;
+            block.inputGaindB  = isStrip (testCase.path) ? -10.0f + random.nextFloat() * 20.0f : 0.0f;
+            block.outputGaindB = isStrip (testCase.path) ? -10.0f + random.nextFloat() * 20.0f : 0.0f;
+            block.isBypassed   = isBypassed = testCase.path == Path::bypass && ! isBypassed;
+            nextChange = position + random.nextInt (4800);
+        }
+
+        blocks.push_back (block);
+        position += block.numSamples;
+    }
+
+    return blocks;
+}
+
+/** What a path, or the reference, produced, and what it reported along the way */
+template <typename SampleType>
+struct Rendering
+{
+    juce::AudioBuffer<SampleType> output;
+    int latencySamples = 0;
+    double deviationdB = 0.0;
+
+    /** Of a reference with an RMS detector, the outputs at the lower and at
+        the upper bound of the detector, see ReferenceDetector */
+    std::vector<juce::AudioBuffer<SampleType>> boundOutputs;
+};
+
+template <typename SampleType>
+static void setParameters (Compressor<SampleType>& compressor, const Case& testCase)
+{
+    compressor.setThreshold (testCase.thresholddB);
+    compressor.setRatio     (static_cast<SampleType> (testCase.ratio));
+    compressor.setKneeWidth (testCase.kneedB);
+    compressor.setAttack    (testCase.attackTime);
+    compressor.setRelease   (testCase.releaseTime);
+    compressor.setGainEngine (testCase.path == Path::fastBlock ? GainEngine::fastApproximation : GainEngine::exact);
+    compressor.setDetectorLink (testCase.detectorLink);
+    compressor.setDetectorHighPass (testCase.highPassFrequency);
+    compressor.setDetectorMode (testCase.rmsWindowTime > 0.0f ? DetectorMode::rms : DetectorMode::peak);
+
+    if (testCase.rmsWindowTime > 0.0f)
+        compressor.setRmsWindow (testCase.rmsWindowTime);
+
+    compressor.setControlRateInterval (testCase.controlRateInterval);
+    compressor.setDeviationMeasurementEnabled (testCase.path == Path::controlRate);
+    compressor.setLookahead (testCase.lookaheadTime);
+}
+
+template <typename SampleType>
+static Rendering<SampleType> renderOptimized (const Case& testCase, const juce::AudioBuffer<SampleType>& input,
+                                              const juce::AudioBuffer<SampleType>& key,
+                                              const std::vector<Block>& blocks, double sampleRate)
+{
+    const auto numChannels = input.getNumChannels();
+    const juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32> (maxBlockSize << testCase.keyRateShift),
+                                        static_cast<juce::uint32> (numChannels) };
+
+    Rendering<SampleType> rendering;
+    rendering.output.setSize (numChannels, input.getNumSamples());
+
+    const juce::dsp::AudioBlock<const SampleType> inputBlock (input.getArrayOfReadPointers(), static_cast<size_t> (numChannels),
+                                                              static_cast<size_t> (input.getNumSamples()));
+    const juce::dsp::AudioBlock<SampleType> outputBlock (rendering.output);
+
+    if (isStrip (testCase.path))
+    {
+        ChannelStrip<SampleType> channelStrip;
+        channelStrip.setOversamplingLimit (testCase.oversamplingFactorLog2);
+        channelStrip.setOversampling (testCase.oversamplingFactorLog2, testCase.useLinearPhase);
+        channelStrip.setRampDurationSeconds (testCase.rampSeconds);
+        channelStrip.setLookahead (static_cast<SampleType> (testCase.lookaheadTime));
+        setParameters (channelStrip.getCompressor(), testCase);
+        channelStrip.prepare (spec);
+
+        for (const auto& block : blocks)
+        {
+            if (block.isAutomated)
+            {
+                channelStrip.setInputGainDecibels  (block.inputGaindB);
+                channelStrip.setOutputGainDecibels (block.outputGaindB);
+                channelStrip.setBypassed (block.isBypassed);
+            }
+
+            auto blockOutput = outputBlock.getSubBlock (static_cast<size_t> (block.position), static_cast<size_t> (block.numSamples));
+            channelStrip.process (juce::dsp::ProcessContextNonReplacing<SampleType> (inputBlock.getSubBlock (static_cast<size_t> (block.position),
+                                                                                                             static_cast<size_t> (block.numSamples)),
+                                                                                     blockOutput));
+        }
+
+        rendering.latencySamples = channelStrip.getLatencySamples();
+        return rendering;
+    }
+
+    Compressor<SampleType> compressor;
+    setParameters (compressor, testCase);
+    compressor.setRampDurationSeconds (testCase.rampSeconds);
+    compressor.prepare (spec);
+
+    const juce::dsp::AudioBlock<const SampleType> keyBlock (key.getArrayOfReadPointers(), static_cast<size_t> (key.getNumChannels()),
+                                                            static_cast<size_t> (key.getNumSamples()));
+
+    for (const auto& block : blocks)
+    {
+        if (block.isAutomated)
+            compressor.setThreshold (block.thresholddB);
+
+        const auto blockKey = key.getNumChannels() == 0 ? keyBlock
+                                                        : keyBlock.getSubBlock (static_cast<size_t> (block.position >> testCase.keyRateShift),
+                                                                                static_cast<size_t> (block.numSamples >> testCase.keyRateShift));
+
+        compressor.processBlock (inputBlock .getSubBlock (static_cast<size_t> (block.position), static_cast<size_t> (block.numSamples)),
+                                 outputBlock.getSubBlock (static_cast<size_t> (block.position), static_cast<size_t> (block.numSamples)),
+                                 nullptr, nullptr, blockKey, testCase.keyRateShift);
+    }
+
+    rendering.latencySamples = compressor.getLatencySamples();
+    rendering.deviationdB    = static_cast<double> (compressor.getControlRateDeviationDecibels());
+    return rendering;
+}
+
+/** Keeps the full rate gains only at the control points of each block and
+    interpolates linearly in between, see renderReference(). Returns the
+    largest ratio between an interpolated and a full rate gain in dB. */
+template <typename SampleType>
+static double interpolateGains (juce::AudioBuffer<SampleType>& gains, const std::vector<Block>& blocks, int interval)
+{
+    constexpr auto chunkSize = static_cast<int> (Compressor<SampleType>::maxChunkSize);
+    auto deviationdB = 0.0;
+
+    for (int channel = 0; channel < gains.getNumChannels(); ++channel)
+    {
+        auto* channelGains = gains.getWritePointer (channel);
+        auto previous = static_cast<SampleType> (1.0);
+
+        for (const auto& block : blocks)
+        {
+            for (int chunkStart = 0; chunkStart < block.numSamples; chunkStart += chunkSize)
+            {
+                const auto chunkEnd = juce::jmin (block.numSamples, chunkStart + chunkSize);
+
+                for (int segmentStart = chunkStart; segmentStart < chunkEnd; segmentStart += interval)
+                {
+                    const auto segmentLength = juce::jmin (interval, chunkEnd - segmentStart);
+                    auto* segment = channelGains + block.position + segmentStart;
+                    const auto target = segment[segmentLength - 1];
+                    const auto step = (target - previous) * (static_cast<SampleType> (1.0) / static_cast<SampleType> (segmentLength));
+
+                    for (int i = 0; i + 1 < segmentLength; ++i)
+                    {
+                        const auto interpolated = previous + step * static_cast<SampleType> (i + 1);
+                        deviationdB = juce::jmax (deviationdB, std::abs (20.0 * std::log10 (static_cast<double> (interpolated)
+                                                                                            / static_cast<double> (segment[i]))));
+                        segment[i] = interpolated;
+                    }
+
+                    previous = target;
+                }
+            }
+        }
+    }
+
+    return deviationdB;
+}
+
+/** The detector signal of the reference, in the plainest arithmetic that
+    follows Compressor's documented behaviour: the key or the input, each
+    channel high-passed by a transposed direct form II biquad with the RBJ
+    cookbook coefficients, in double whatever the sample type, then, for a linked detector or a key that is
+    neither mono nor one channel per input channel, folded into one signal
+    by the largest or the mean magnitude. The RMS detector sums the squares
+    of its whole window again on every sample.
+
+    Compressor keeps a running sum instead, rounded on every sample and
+    summed again on every wrap of the window, so it is off by up to a few
+    windowSize epsilons of the largest sum since that wrap. Right after a
+    loud passage that is a lot more than the sum of a quiet one, so the RMS
+    detector also gives the values at both ends of that bound. */
+template <typename SampleType>
+class ReferenceDetector
+{
+public:
+    ReferenceDetector (const Case& testCase, int numInputChannels, double sampleRate)
+        : numChannels (numInputChannels),
+          numSources (testCase.numKeyChannels > 0 ? juce::jmin (testCase.numKeyChannels, static_cast<int> (Compressor<SampleType>::maxKeyChannels))
+                                                  : numInputChannels),
+          isFolded (testCase.detectorLink != DetectorLink::independent
+                    || (testCase.numKeyChannels > 0 && numSources != 1 && numSources != numInputChannels)),
+          useMean (testCase.detectorLink == DetectorLink::mean),
+          useFilter (testCase.highPassFrequency > 0.0f)
+    {
+        if (useFilter)
+        {
+            // Butterworth, Q = 1 / sqrt (2), normalised by 1 / a0
+            const auto frequency = juce::jmin (static_cast<double> (testCase.highPassFrequency), 0.45 * sampleRate);
+            const auto w0        = 2.0 * juce::MathConstants<double>::pi * frequency / sampleRate;
+            const auto alpha     = std::sin (w0) / juce::MathConstants<double>::sqrt2;
+            const auto a0Inverse = 1.0 / (1.0 + alpha);
+
+            b0 = 0.5 * (1.0 + std::cos (w0)) * a0Inverse;
+            b1 = -(1.0 + std::cos (w0)) * a0Inverse;
+            b2 = b0;
+            a1 = -2.0 * std::cos (w0) * a0Inverse;
+            a2 = (1.0 - alpha) * a0Inverse;
+        }
+
+        if (testCase.rmsWindowTime > 0.0f)
+            windowSize = static_cast<size_t> (juce::jlimit (1, juce::roundToInt (Compressor<SampleType>::maxRmsWindowMs * 0.001 * sampleRate),
+                                                            juce::roundToInt (static_cast<double> (testCase.rmsWindowTime) * 0.001 * sampleRate)));
+
+        reset();
+    }
+
+    void reset()
+    {
+        state1.assign ((size_t) numSources, 0.0);
+        state2.assign ((size_t) numSources, 0.0);
+        squares.assign ((size_t) getNumChannels(), std::vector<SampleType> (windowSize, static_cast<SampleType> (0.0)));
+        sums.assign ((size_t) getNumChannels(), std::vector<double> (windowSize + 1, 0.0));
+        windowPosition = sumPosition = 0;
+    }
+
+    int getNumSources() const  { return numSources; }
+    int getNumChannels() const { return isFolded ? 1 : numChannels; }
+
+    /** 3 with an RMS detector: the value, its lower and its upper bound */
+    int getNumValues() const { return windowSize > 0 ? 3 : 1; }
+
+    /** Turns getNumSources() values of the key or of the input into
+        getNumChannels() detector values, for each of getNumValues() */
+    void process (std::vector<SampleType>& sources, std::vector<std::vector<SampleType>>& values)
+    {
+        auto& detector = values[0];
+
+        if (useFilter)
+        {
+            for (size_t source = 0; source < sources.size(); ++source)
+            {
+                const auto x = static_cast<double> (sources[source]);
+                const auto y = b0 * x + state1[source];
+
+                state1[source] = b1 * x - a1 * y + state2[source];
+                state2[source] = b2 * x - a2 * y;
+                sources[source] = static_cast<SampleType> (y);
+            }
+        }
+
+        if (isFolded)
+        {
+            auto folded = static_cast<SampleType> (0.0);
+
+            for (auto value : sources)
+                folded = useMean ? folded + std::abs (value) : juce::jmax (folded, std::abs (value));
+
+            if (useMean)
+                folded *= static_cast<SampleType> (1.0) / static_cast<SampleType> (numSources);
+
+            detector[0] = folded;
+        }
+        else
+        {
+            for (size_t channel = 0; channel < detector.size(); ++channel)
+                detector[channel] = sources[numSources == 1 ? 0 : channel];
+        }
+
+        if (windowSize == 0)
+            return;
+
+        for (size_t channel = 0; channel < detector.size(); ++channel)
+        {
+            squares[channel][windowPosition] = detector[channel] * detector[channel];
+
+            auto sum = 0.0;
+
+            for (auto square : squares[channel])
+                sum += static_cast<double> (square);
+
+            // The last wrap is at most windowSize samples back
+            sums[channel][sumPosition] = sum;
+            const auto largestSum = *std::max_element (sums[channel].begin(), sums[channel].end());
+            const auto error = 4.0 * static_cast<double> (windowSize) * std::numeric_limits<SampleType>::epsilon() * largestSum;
+
+            const auto getLevel = [this] (double value) { return static_cast<SampleType> (std::sqrt (juce::jmax (0.0, value) / static_cast<double> (windowSize))); };
+            detector [channel] = getLevel (sum);
+            values[1][channel] = getLevel (sum - error);
+            values[2][channel] = getLevel (sum + error);
+        }
+
+        windowPosition = (windowPosition + 1) % windowSize;
+        sumPosition    = (sumPosition + 1) % (windowSize + 1);
+    }
+
+private:
+    const int numChannels, numSources;
+    const bool isFolded, useMean, useFilter;
+
+    double b0 = 0, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    std::vector<double> state1, state2;
+
+    size_t windowSize = 0, windowPosition = 0, sumPosition = 0;
+    std::vector<std::vector<SampleType>> squares;
+    std::vector<std::vector<double>> sums;
+};
+
+/** The reference, one frame at a time. The detector is fed as the
+    ReferenceDetector describes. The ramps of the threshold and the gains
+    are replayed from the blocks, and the audio, not the detector, is
+    delayed by latencySamples. A key sample stands for 2^keyRateShift input
+    samples.
+
+    At a control rate the gains of the reference are only kept at the
+    control points, the last sample of every interval counted from the start
+    of each chunk of Compressor::maxChunkSize samples of a block, and
+    interpolated linearly in between, from the last control point of the
+    channel. The deviation is the largest ratio between those and the full
+    rate gains, in dB.
+
+    The threshold follows an exact linear ramp. The gains come from the same
+    ParameterRamp as the strip's: the input gain feeds the envelope, and in
+    float a peak envelope carries the last bit of its input through a whole
+    release, so gains rounded any differently would show up as an error of
+    the compressor.
+
+    The bypass mixes in the input, delayed by latencySamples, with a linear
+    juce::SmoothedValue over ChannelStrip::bypassFadeSeconds. Fully bypassed,
+    nothing but the gain ramps moves on. Leaving it restarts the reference
+    and the ramps, and holds the dry signal for latencySamples before the
+    fade starts, all from the start of a block, where the strip checks the
+    bypass. */
+template <typename SampleType>
+static Rendering<SampleType> renderReference (const Case& testCase, const juce::AudioBuffer<SampleType>& input,
+                                              const juce::AudioBuffer<SampleType>& key,
+                                              const std::vector<Block>& blocks, int latencySamples, double sampleRate)
+{
+    const auto numChannels = input.getNumChannels();
+    const auto length      = input.getNumSamples();
+    const auto isRamping   = testCase.path == Path::thresholdRamp;
+
+    ReferenceDetector<SampleType> detector (testCase, numChannels, sampleRate);
+    const auto numValues = (size_t) detector.getNumValues();
+    std::vector<SampleType> sources ((size_t) detector.getNumSources());
+    std::vector<std::vector<SampleType>> detectorValues (numValues, std::vector<SampleType> ((size_t) detector.getNumChannels()));
+
+    // One per detector value. The ballistics and the gain computer never go
+    // the other way than their input, so the gains at the bounds of the
+    // detector hold every gain in between.
+    std::vector<ReferenceCompressor<SampleType>> references (numValues);
+
+    for (auto& reference : references)
+    {
+        reference.setThreshold (testCase.thresholddB);
+        reference.setRatio     (static_cast<SampleType> (testCase.ratio));
+        reference.setKneeWidth (testCase.kneedB);
+        reference.setAttack    (testCase.attackTime);
+        reference.setRelease   (testCase.releaseTime);
+        reference.prepare (sampleRate, detector.getNumChannels());
+    }
+
+    // The threshold ramps as the ratio of the threshold the VCA is at to the
+    // one that was set, see Compressor::thresholdScale
+    const auto rampLength = static_cast<int> (std::floor (testCase.rampSeconds * sampleRate));
+    LinearRamp thresholdScale;
+    ParameterRamp<SampleType> inputGain, outputGain;
+    inputGain .reset (sampleRate, testCase.rampSeconds);
+    outputGain.reset (sampleRate, testCase.rampSeconds);
+    inputGain .setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+    outputGain.setCurrentAndTargetValue (static_cast<SampleType> (1.0));
+    auto thresholddB = static_cast<double> (testCase.thresholddB);
+    auto threshold   = static_cast<double> (juce::Decibels::decibelsToGain (static_cast<SampleType> (testCase.thresholddB), static_cast<SampleType> (-200.0)));
+
+    juce::SmoothedValue<SampleType> dryMix;
+    dryMix.reset (sampleRate, ChannelStrip<SampleType>::bypassFadeSeconds);
+    dryMix.setCurrentAndTargetValue (static_cast<SampleType> (0.0));
+    auto isFullyBypassed = false, isFading = false;
+    int primingSamples = 0, restartPosition = 0;
+
+    // The full rate gains first, the control rate needs the ones ahead
+    std::vector<juce::AudioBuffer<SampleType>> gains (numValues, juce::AudioBuffer<SampleType> (numChannels, length));
+    std::vector<SampleType> inputGainValues ((size_t) length), outputGainValues ((size_t) length), dryMixValues ((size_t) length);
+    std::vector<int> restartPositions ((size_t) length);
+    const auto* const* inputChannels = input.getArrayOfReadPointers();
+    const auto* const* keyChannels   = key.getArrayOfReadPointers();
+    auto block = blocks.begin();
+
+    for (int i = 0; i < length; ++i)
+    {
+        if (block != blocks.end() && block->position == i)
+        {
+            if (block->isAutomated)
+            {
+                const auto newThreshold = static_cast<double> (juce::Decibels::decibelsToGain (static_cast<SampleType> (block->thresholddB),
+                                                                                               static_cast<SampleType> (-200.0)));
+
+                if (newThreshold != threshold)
+                {
+                    thresholdScale.jumpTo (thresholdScale.getCurrent() * newThreshold / threshold);
+                    thresholdScale.rampTo (1.0, rampLength);
+                    threshold   = newThreshold;
+                    thresholddB = block->thresholddB;
+                }
+
+                inputGain .setTargetValue (juce::Decibels::decibelsToGain (static_cast<SampleType> (block->inputGaindB)));
+                outputGain.setTargetValue (juce::Decibels::decibelsToGain (static_cast<SampleType> (block->outputGaindB)));
+            }
+
+            const auto dryMixTarget = static_cast<SampleType> (block->isBypassed ? 1.0 : 0.0);
+            isFullyBypassed = ! dryMix.isSmoothing() && dryMix.getCurrentValue() == static_cast<SampleType> (1.0);
+
+            if (dryMixTarget != dryMix.getTargetValue())
+            {
+                if (isFullyBypassed)
+                {
+                    for (auto& reference : references)
+                        reference.reset();
+
+                    detector.reset();
+                    inputGain .reset (sampleRate, testCase.rampSeconds);
+                    outputGain.reset (sampleRate, testCase.rampSeconds);
+                    primingSamples  = latencySamples;
+                    restartPosition = i;
+                }
+
+                dryMix.setTargetValue (dryMixTarget);
+            }
+
+            isFading        = dryMix.isSmoothing();
+            isFullyBypassed = ! isFading && dryMix.getCurrentValue() == static_cast<SampleType> (1.0);
+            ++block;
+        }
+
+        if (isRamping)
+        {
+            const auto rampedThreshold = static_cast<SampleType> (thresholddB - 20.0 * std::log10 (thresholdScale.getNext()));
+
+            for (auto& reference : references)
+                reference.setThreshold (rampedThreshold);
+        }
+
+        inputGain .fill (&inputGainValues [(size_t) i], 1);
+        outputGain.fill (&outputGainValues[(size_t) i], 1);
+
+        restartPositions[(size_t) i] = restartPosition;
+
+        auto& dryMixValue = dryMixValues[(size_t) i];
+        dryMixValue = static_cast<SampleType> (isFullyBypassed ? 1.0 : 0.0);
+
+        if (isFading)
+        {
+            dryMixValue = primingSamples > 0 ? static_cast<SampleType> (1.0) : dryMix.getNextValue();
+            primingSamples = juce::jmax (0, primingSamples - 1);
+        }
+
+        if (isFullyBypassed)
+        {
+            for (auto& gain : gains)
+                for (int channel = 0; channel < numChannels; ++channel)
+                    gain.setSample (channel, i, static_cast<SampleType> (0.0));
+
+            continue;
+        }
+
+        for (int source = 0; source < detector.getNumSources(); ++source)
+            sources[(size_t) source] = key.getNumChannels() > 0 ? keyChannels[source][i >> testCase.keyRateShift]
+                                                                 : inputChannels[source][i] * inputGainValues[(size_t) i];
+
+        detector.process (sources, detectorValues);
+
+        for (size_t value = 0; value < numValues; ++value)
+        {
+            auto* const* gainChannels = gains[value].getArrayOfWritePointers();
+
+            for (int channel = 0; channel < detector.getNumChannels(); ++channel)
+                gainChannels[channel][i] = references[value].getGain (channel, detectorValues[value][(size_t) channel]);
+
+            for (int channel = detector.getNumChannels(); channel < numChannels; ++channel)
+                gainChannels[channel][i] = gainChannels[0][i];
+        }
+    }
+
+    Rendering<SampleType> rendering;
+
+    if (testCase.controlRateInterval > 1)
+        rendering.deviationdB = interpolateGains (gains[0], blocks, testCase.controlRateInterval);
+
+    const auto renderOutput = [&] (const juce::AudioBuffer<SampleType>& gain)
+    {
+        juce::AudioBuffer<SampleType> output (numChannels, length);
+        auto* const* outputChannels = output.getArrayOfWritePointers();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int i = 0; i < length; ++i)
+            {
+                // The lookahead starts from silence whenever the processing restarts
+                const auto delayed = i - latencySamples;
+                const auto audio   = delayed >= restartPositions[(size_t) i] ? inputChannels[channel][delayed] * inputGainValues[(size_t) delayed]
+                                                                           : static_cast<SampleType> (0.0);
+                const auto dry     = delayed >= 0 ? inputChannels[channel][delayed] : static_cast<SampleType> (0.0);
+                const auto wet     = gain.getSample (channel, i) * audio * outputGainValues[(size_t) i];
+                const auto dryMixValue = dryMixValues[(size_t) i];
+
+                outputChannels[channel][i] = wet * (static_cast<SampleType> (1.0) - dryMixValue) + dry * dryMixValue;
+            }
+        }
+
+        return output;
+    };
+
+    rendering.output = renderOutput (gains[0]);
+
+    for (size_t value = 1; value < numValues; ++value)
+        rendering.boundOutputs.push_back (renderOutput (gains[value]));
+
+    rendering.latencySamples = latencySamples;
+    return rendering;
+}
+
+/** The reference of the oversampled strip: the input upsampled with
+    juce::dsp::Oversampling of the same factor and filters, the reference at
+    the oversampled rate, and back down through another such oversampler.
+    The filters are JUCE's, what's checked is how the strip runs the
+    compressor and the gains between them. */
+template <typename SampleType>
+static Rendering<SampleType> renderResampledReference (const Case& testCase, const juce::AudioBuffer<SampleType>& input,
+                                                       const std::vector<Block>& blocks, double sampleRate)
+{
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+
+    const auto numChannels = input.getNumChannels();
+    const auto length      = input.getNumSamples();
+    const auto factorLog2  = testCase.oversamplingFactorLog2;
+    const auto filterType  = testCase.useLinearPhase ? Oversampler::filterHalfBandFIREquiripple : Oversampler::filterHalfBandPolyphaseIIR;
+
+    Oversampler upsampler   ((size_t) numChannels, (size_t) factorLog2, filterType, true, true);
+    Oversampler downsampler ((size_t) numChannels, (size_t) factorLog2, filterType, true, true);
+    upsampler  .initProcessing ((size_t) maxBlockSize);
+    downsampler.initProcessing ((size_t) maxBlockSize);
+
+    const juce::dsp::AudioBlock<const SampleType> inputBlock (input.getArrayOfReadPointers(), static_cast<size_t> (numChannels),
+                                                              static_cast<size_t> (length));
+    juce::AudioBuffer<SampleType> upsampled (numChannels, length << factorLog2);
+    juce::dsp::AudioBlock<SampleType> upsampledBlock (upsampled);
+
+    for (int position = 0; position < length; position += maxBlockSize)
+    {
+        const auto numSamples = juce::jmin (maxBlockSize, length - position);
+        upsampledBlock.getSubBlock ((size_t) position << factorLog2, (size_t) numSamples << factorLog2)
+                      .copyFrom (upsampler.processSamplesUp (inputBlock.getSubBlock ((size_t) position, (size_t) numSamples)));
+    }
+
+    auto oversampledBlocks = blocks;
+
+    for (auto& block : oversampledBlocks)
+    {
+        block.position   <<= factorLog2;
+        block.numSamples <<= factorLog2;
+    }
+
+    const auto oversampled = renderReference (testCase, upsampled, juce::AudioBuffer<SampleType>(), oversampledBlocks, 0,
+                                              sampleRate * (1 << factorLog2));
+
+    Rendering<SampleType> rendering;
+    rendering.output.setSize (numChannels, length);
+    juce::dsp::AudioBlock<SampleType> outputBlock (rendering.output);
+    const juce::dsp::AudioBlock<const SampleType> oversampledBlock (oversampled.output.getArrayOfReadPointers(), static_cast<size_t> (numChannels),
+                                                                    static_cast<size_t> (length << factorLog2));
+
+    for (int position = 0; position < length; position += maxBlockSize)
+    {
+        const auto numSamples = juce::jmin (maxBlockSize, length - position);
+
+        // Only for the buffer to write the oversampled signal to
+        downsampler.processSamplesUp (inputBlock.getSubBlock ((size_t) position, (size_t) numSamples))
+                   .copyFrom (oversampledBlock.getSubBlock ((size_t) position << factorLog2, (size_t) numSamples << factorLog2));
+        downsampler.processSamplesDown (outputBlock.getSubBlock ((size_t) position, (size_t) numSamples));
+    }
+
+    rendering.latencySamples = juce::roundToInt (downsampler.getLatencyInSamples());
+    return rendering;
+}
+
+/** The largest sum of the magnitudes of the downsampling filters over the
+    oversampled samples that make up one output sample. An error of every
+    oversampled sample adds up to at most that much in the output. */
+template <typename SampleType>
+static double getReconstructionGain (const Case& testCase)
+{
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+
+    const auto factor     = 1 << testCase.oversamplingFactorLog2;
+    const auto filterType = testCase.useLinearPhase ? Oversampler::filterHalfBandFIREquiripple : Oversampler::filterHalfBandPolyphaseIIR;
+    constexpr int numBlocks = 8;
+
+    juce::AudioBuffer<SampleType> silence (1, maxBlockSize), response (1, maxBlockSize);
+    silence.clear();
+    juce::dsp::AudioBlock<SampleType> responseBlock (response);
+    const juce::dsp::AudioBlock<const SampleType> silentBlock (silence.getArrayOfReadPointers(), 1, (size_t) maxBlockSize);
+
+    // The filters decimate, so every phase of the impulse counts
+    auto gain = 0.0;
+
+    for (int phase = 0; phase < factor; ++phase)
+    {
+        Oversampler oversampler (1, (size_t) testCase.oversamplingFactorLog2, filterType, true, true);
+        oversampler.initProcessing ((size_t) maxBlockSize);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            auto oversampled = oversampler.processSamplesUp (silentBlock);
+            oversampled.clear();
+
+            if (i == 0)
+                oversampled.getChannelPointer (0)[phase] = static_cast<SampleType> (1.0);
+
+            oversampler.processSamplesDown (responseBlock);
+
+            for (int sample = 0; sample < maxBlockSize; ++sample)
+                gain += std::abs (static_cast<double> (response.getReadPointer (0)[sample]));
+        }
+    }
+
+    return gain;
+}
+
+/** The reference in double, on the same signals as a float case */
+static Rendering<double> renderDoubleReference (const Case& testCase, const juce::AudioBuffer<float>& input,
+                                                const juce::AudioBuffer<float>& key, const std::vector<Block>& blocks,
+                                                int latencySamples, double sampleRate)
+{
+    juce::AudioBuffer<double> doubleInput, doubleKey;
+    doubleInput.makeCopyOf (input);
+    doubleKey  .makeCopyOf (key);
+
+    if (testCase.oversamplingFactorLog2 > 0)
+        return renderResampledReference (testCase, doubleInput, blocks, sampleRate);
+
+    return renderReference (testCase, doubleInput, doubleKey, blocks, latencySamples, sampleRate);
+}
+
+/** Widens a float tolerance by the measured error of the float reference,
+    the difference to the double one. A float path rounds differently but
+    no worse, so it can be as far off in the other direction. */
+static Tolerance addFloatError (Tolerance tolerance, const Result& floatError)
+{
+    tolerance.maxErrordB    = juce::jmax (tolerance.maxErrordB, 2.0 * floatError.maxErrordB);
+    tolerance.maxResidualdB = juce::jmax (tolerance.maxResidualdB, floatError.residualdB + 20.0 * std::log10 (2.0));
+    return tolerance;
+}
+
+template <typename SampleType>
+static Result runCase (const Case& testCase, const ConformanceSettings& settings, juce::Random& random)
+{
+    // Whole key samples
+    const auto length = (static_cast<int> (settings.seconds * settings.sampleRate) >> testCase.keyRateShift) << testCase.keyRateShift;
+    const auto input  = makeSignal<SampleType> (testCase.numChannels, length, settings.sampleRate, random);
+    const auto key    = makeSignal<SampleType> (testCase.numKeyChannels, length >> testCase.keyRateShift, settings.sampleRate, random);
+    const auto blocks = createBlocks (testCase, length, random);
+
+    const auto rendering = renderOptimized (testCase, input, key, blocks, settings.sampleRate);
+    const auto isOversampled = testCase.oversamplingFactorLog2 > 0;
+    const auto levelRadius   = isOversampled ? 2 * rendering.latencySamples + 1 : 0;
+    auto tolerance = getTolerance<SampleType> (testCase.path);
+
+    if (isOversampled)
+    {
+        // The filters back down add up the errors of the oversampled gains
+        const auto reconstructionGain = getReconstructionGain<SampleType> (testCase);
+        tolerance.maxErrordB    *= reconstructionGain;
+        tolerance.maxResidualdB += 20.0 * std::log10 (reconstructionGain);
+    }
+
+    auto expected = isOversampled ? renderResampledReference (testCase, input, blocks, settings.sampleRate)
+                                  : renderReference (testCase, input, key, blocks, rendering.latencySamples, settings.sampleRate);
+
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        juce::AudioBuffer<double> floatExpected;
+        floatExpected.makeCopyOf (expected.output);
+
+        const auto doubleExpected = renderDoubleReference (testCase, input, key, blocks, rendering.latencySamples, settings.sampleRate);
+        tolerance = addFloatError (tolerance, compare (floatExpected, doubleExpected.output, tolerance, levelRadius));
+    }
+
+    if (isOversampled)
+        return compare (rendering.output, expected.output, tolerance, levelRadius);
+
+    // Anything between the outputs at the bounds of an RMS detector is as
+    // right as the reference itself
+    if (! expected.boundOutputs.empty())
+    {
+        for (int channel = 0; channel < expected.output.getNumChannels(); ++channel)
+        {
+            auto* expectedSamples = expected.output.getWritePointer (channel);
+            const auto* outputSamples = rendering.output.getReadPointer (channel);
+
+            for (int i = 0; i < expected.output.getNumSamples(); ++i)
+            {
+                auto lowest = expectedSamples[i], highest = expectedSamples[i];
+
+                for (const auto& boundOutput : expected.boundOutputs)
+                {
+                    lowest  = juce::jmin (lowest,  boundOutput.getSample (channel, i));
+                    highest = juce::jmax (highest, boundOutput.getSample (channel, i));
+                }
+
+                expectedSamples[i] = juce::jlimit (lowest, highest, outputSamples[i]);
+            }
+        }
+    }
+
+    auto result = compare (rendering.output, expected.output, tolerance);
+    result.deviationErrordB = std::abs (rendering.deviationdB - expected.deviationdB);
+    result.passed = result.passed && result.deviationErrordB <= 2.0 * tolerance.maxErrordB;
+    return result;
+}
+
+static juce::Array<Case> createCases (juce::Random& random)
+{
+    juce::Array<Case> cases;
+    int index = 0;
+
+    // The ends of a range, then a random value in between
+    const auto pick = [&random] (int step, float start, float end)
+    {
+        switch (step % 3)
+        {
+            case 0:  return start;
+            case 1:  return end;
+            default: return start + random.nextFloat() * (end - start);
+        }
+    };
+
+    // Mono, one channel per input channel, narrower or wider, and once
+    // wider than the detector reads
+    const auto getKeyWidth = [&random] (int step, int numChannels)
+    {
+        switch (step % 4)
+        {
+            case 0:  return 1;
+            case 1:  return numChannels;
+            case 2:  return numChannels > 2 ? 2 + random.nextInt (numChannels - 2) : numChannels + 1;
+            default: return numChannels == 9 ? static_cast<int> (Compressor<float>::maxKeyChannels) + 6
+                                             : numChannels + 1 + random.nextInt (numChannels + 1);
+        }
+    };
+
+    const std::vector<DetectorLink> links { DetectorLink::independent, DetectorLink::maximum, DetectorLink::mean };
+
+    for (auto path : { Path::exactBlock, Path::fastBlock, Path::linkedBlock, Path::meanLinkedBlock, Path::controlRate,
+                       Path::thresholdRamp, Path::lookahead, Path::sidechain, Path::highPass, Path::rms,
+                       Path::channelStrip, Path::oversampledStrip, Path::bypass })
+        for (auto useDoublePrecision : { false, true })
+            for (auto ratio : { 4, 8, 12, 20 })
+                for (auto numChannels : { 1, 2, 3, 5, 8, 9 })
+                    for (auto blockSize : { 1, 3, 16, 64, 65, 480, 4096, 0 })
+                    {
+                        const auto thresholddB = -60.0f + random.nextFloat() * 70.0f;
+                        const auto kneedB = index % 2 == 0 ? 0.0f : random.nextFloat() * 24.0f;
+
+                        Case testCase { path, useDoublePrecision, ratio, numChannels, blockSize, thresholddB, kneedB,
+                                        pick (index, 20.0f, 800.0f), pick (index / 3, 50.0f, 1100.0f) };
+
+                        if (path == Path::linkedBlock)
+                            testCase.detectorLink = DetectorLink::maximum;
+
+                        if (path == Path::meanLinkedBlock)
+                            testCase.detectorLink = DetectorLink::mean;
+
+                        if (path == Path::sidechain || path == Path::highPass || path == Path::rms)
+                            testCase.detectorLink = links[(size_t) (index / 4) % links.size()];
+
+                        if (path == Path::controlRate)
+                            testCase.controlRateInterval = 2 << random.nextInt (6);
+
+                        if (path == Path::lookahead || (path == Path::bypass && index % 2 == 0))
+                            testCase.lookaheadTime = pick (index / 9, 0.02f, static_cast<float> (Compressor<float>::maxLookaheadMs));
+
+                        if (path == Path::thresholdRamp || isStrip (path))
+                            testCase.rampSeconds = pick (index / 9, 0.001f, 0.05f);
+
+                        if (path == Path::sidechain || (path == Path::highPass && index % 2 == 0))
+                            testCase.numKeyChannels = getKeyWidth (index, numChannels);
+
+                        if (path == Path::sidechain)
+                            testCase.keyRateShift = (index / 12) % 3;
+
+                        if (path == Path::highPass || (path == Path::rms && index % 3 == 0))
+                            testCase.highPassFrequency = pick (index / 3, 20.0f, 2000.0f);
+
+                        if (path == Path::rms)
+                            testCase.rmsWindowTime = pick (index / 9, 1.0f, static_cast<float> (Compressor<float>::maxRmsWindowMs));
+
+                        if (path == Path::oversampledStrip)
+                        {
+                            testCase.oversamplingFactorLog2 = 1 + index % ChannelStrip<float>::maxOversamplingFactorLog2;
+                            testCase.useLinearPhase = (index / 3) % 2 == 1;
+
+                            // The lowest cutoff at the highest rate, where the
+                            // biquad needs the most precision
+                            if (testCase.oversamplingFactorLog2 == ChannelStrip<float>::maxOversamplingFactorLog2 && (index / 6) % 2 == 0)
+                                testCase.highPassFrequency = 20.0f;
+                        }
+
+                        cases.add (testCase);
+                        ++index;
+                    }
+
+    return cases;
+}
+
+//==============================================================================
+/** The compressor before any of the optimizations, as it was: peak
+    ballistics from juce::dsp::BallisticsFilter<float>, then std::pow in
+    float. The attack and release go to the filter as they are. */
+class BaselineCompressor
+{
+public:
+    BaselineCompressor (float thresholddB, int ratio, float attackTime, float releaseTime)
+        : threshold (juce::Decibels::decibelsToGain (thresholddB, -200.0f)),
+          thresholdInverse (1.0f / threshold),
+          ratioInverse (1.0f / static_cast<float> (ratio)),
+          attack (attackTime), release (releaseTime) {}
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        // The times after prepare(), which sets the rate they depend on
+        envelopeFilter.prepare (spec);
+        envelopeFilter.setAttackTime (attack);
+        envelopeFilter.setReleaseTime (release);
+        envelopeFilter.reset();
+    }
+
+    float processSample (int channel, float inputValue)
+    {
+        auto env = envelopeFilter.processSample (channel, inputValue);
+
+        auto gain = (env < threshold) ? 1.0f
+                                      : std::pow (env * thresholdInverse, ratioInverse - 1.0f);
+
+        return gain * inputValue;
+    }
+
+private:
+    juce::dsp::BallisticsFilter<float> envelopeFilter;
+    const float threshold, thresholdInverse, ratioInverse, attack, release;
+};
+
+/** ReferenceCompressor<float> with a hard knee against BaselineCompressor,
+    which have to agree exactly */
+static Result runBaselineCase (int ratio, int numChannels, float thresholddB, float attackTime, float releaseTime,
+                               const ConformanceSettings& settings, juce::Random& random)
+{
+    const auto length = static_cast<int> (settings.seconds * settings.sampleRate);
+    const auto input  = makeSignal<float> (numChannels, length, settings.sampleRate, random);
+
+    BaselineCompressor baseline (thresholddB, ratio, attackTime, releaseTime);
+    baseline.prepare ({ settings.sampleRate, static_cast<juce::uint32> (maxBlockSize), static_cast<juce::uint32> (numChannels) });
+
+    ReferenceCompressor<float> reference;
+    reference.setThreshold (thresholddB);
+    reference.setRatio     (static_cast<float> (ratio));
+    reference.setAttack    (attackTime);
+    reference.setRelease   (releaseTime);
+    reference.prepare (settings.sampleRate, numChannels);
+
+    juce::AudioBuffer<float> expected (numChannels, length), output (numChannels, length);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int i = 0; i < length; ++i)
+        {
+            const auto value = input.getSample (channel, i);
+            expected.setSample (channel, i, baseline .processSample (channel, value));
+            output  .setSample (channel, i, reference.processSample (channel, value));
+        }
+    }
+
+    return compare (output, expected, Tolerance { 0.0, -400.0 });
+}
+
+//==============================================================================
+/** The worst of every case of one path and precision */
+struct Summary
+{
+    int numCases = 0, numFailed = 0;
+    Result worst;
+
+    void add (const Result& result)
+    {
+        ++numCases;
+        numFailed += result.passed ? 0 : 1;
+        worst.maxErrordB       = juce::jmax (worst.maxErrordB,       result.maxErrordB);
+        worst.peakResidualdB   = juce::jmax (worst.peakResidualdB,   result.peakResidualdB);
+        worst.residualdB       = juce::jmax (worst.residualdB,       result.residualdB);
+        worst.deviationErrordB = juce::jmax (worst.deviationErrordB, result.deviationErrordB);
+    }
+};
+
+static juce::String describe (const Result& result)
+{
+    auto description = "max error " + juce::String (result.maxErrordB, 9) + " dB  residual peak "
+                     + juce::String (result.peakResidualdB, 1) + " dBFS, rms " + juce::String (result.residualdB, 1) + " dB";
+
+    if (result.deviationErrordB > 0.0)
+        description += "  deviation off by " + juce::String (result.deviationErrordB, 9) + " dB";
+
+    return description;
+}
+
+int main (int argc, char* argv[])
+{
+    ConformanceSettings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto argument = juce::String::fromUTF8 (argv[i]);
+        const auto value    = i + 1 < argc ? juce::String::fromUTF8 (argv[i + 1]) : juce::String();
+
+        if (argument == "--verbose")
+        {
+            settings.verbose = true;
+            continue;
+        }
+
+        if (argument == "--seed" && value.isNotEmpty())
+            settings.seed = value.getLargeIntValue();
+        else if (argument == "--seconds" && value.isNotEmpty())
+            settings.seconds = juce::jmax (0.01, value.getDoubleValue());
+        else
+        {
+            std::cout << "usage: Conformance [--seed n] [--seconds s] [--verbose]" << std::endl;
+            return 1;
+        }
+
+        ++i;
+    }
+
+    juce::Random random (settings.seed);
+    std::map<juce::String, Summary> summaries;
+    int numFailed = 0;
+
+    // The ends of a range, then a random value in between, like createCases()
+    const auto pick = [&random] (int step, float start, float end)
+    {
+        return step % 3 == 0 ? start : step % 3 == 1 ? end : start + random.nextFloat() * (end - start);
+    };
+
+    // The reference first, everything else is checked against it
+    for (auto ratio : { 4, 8, 12, 20 })
+        for (auto numChannels : { 1, 2 })
+            for (int step = 0; step < 9; ++step)
+            {
+                const auto thresholddB = -60.0f + random.nextFloat() * 70.0f;
+                const auto attackTime  = pick (step, 20.0f, 800.0f);
+                const auto releaseTime = pick (step / 3, 50.0f, 1100.0f);
+                const auto result = runBaselineCase (ratio, numChannels, thresholddB, attackTime, releaseTime, settings, random);
+
+                summaries["baseline/float"].add (result);
+
+                if (! result.passed)
+                    ++numFailed;
+
+                if (settings.verbose || ! result.passed)
+                    std::cout << (result.passed ? "ok      " : "FAILED  ") << "baseline/float/ratio " << ratio << "/" << numChannels << "ch/"
+                              << juce::String (thresholddB, 1) << "dB/" << juce::String (attackTime, 1) << "us/"
+                              << juce::String (releaseTime, 1) << "ms  " << describe (result) << std::endl;
+            }
+
+    for (const auto& testCase : createCases (random))
+    {
+        const auto result = testCase.useDoublePrecision ? runCase<double> (testCase, settings, random)
+                                                        : runCase<float>  (testCase, settings, random);
+
+        summaries[juce::String (getPathName (testCase.path)) + "/" + (testCase.useDoublePrecision ? "double" : "float")].add (result);
+
+        if (! result.passed)
+            ++numFailed;
+
+        if (settings.verbose || ! result.passed)
+            std::cout << (result.passed ? "ok      " : "FAILED  ") << testCase.getName() << "  " << describe (result) << std::endl;
+    }
+
+    for (const auto& [name, summary] : summaries)
+        std::cout << name << "  " << summary.numCases - summary.numFailed << " of " << summary.numCases
+                  << " cases passed  worst " << describe (summary.worst) << std::endl;
+
+    if (numFailed > 0)
+    {
+        std::cout << numFailed << " cases exceeded the tolerances (seed " << settings.seed << ")" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}